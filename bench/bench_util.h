@@ -0,0 +1,110 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+// Thread counts from the command line, or `defaults` if none are given.
+inline std::vector<size_t> ParseThreadCounts(int argc, char **argv,
+                                             std::vector<size_t> defaults) {
+  std::vector<size_t> counts;
+  for (int i = 1; i < argc; ++i) {
+    counts.push_back(std::strtoul(argv[i], nullptr, 10));
+  }
+  return counts.empty() ? defaults : counts;
+}
+
+// Runs body(thread_idx, stop) on `threads` threads released at the same
+// moment and stops them after `duration`. body returns the number of
+// operations it has done; the result is the total rate in ops/sec.
+template <typename Body>
+double RunFor(size_t threads, std::chrono::milliseconds duration, Body body) {
+  std::atomic_bool start = false;
+  std::atomic_bool stop = false;
+  std::atomic_size_t ready = 0;
+  std::vector<size_t> ops(threads, 0);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      ++ready;
+      while (!start.load(std::memory_order_acquire)) {
+      }
+      ops[i] = body(i, stop);
+    });
+  }
+
+  while (ready != threads) {
+  }
+  auto ts = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(duration);
+  stop.store(true, std::memory_order_release);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto te = std::chrono::steady_clock::now();
+
+  size_t total = 0;
+  for (size_t n : ops) {
+    total += n;
+  }
+  return total / std::chrono::duration<double>(te - ts).count();
+}
+
+// Runs body(thread_idx) once on `threads` threads released together and
+// returns the wall time in seconds.
+template <typename Body>
+double RunOnce(size_t threads, Body body) {
+  std::atomic_bool start = false;
+  std::atomic_size_t ready = 0;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      ++ready;
+      while (!start.load(std::memory_order_acquire)) {
+      }
+      body(i);
+    });
+  }
+
+  while (ready != threads) {
+  }
+  auto ts = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto te = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(te - ts).count();
+}
+
+inline void PrintHeader(const std::string &title,
+                        const std::vector<std::string> &columns) {
+  std::cout << std::endl << title << std::endl;
+  std::cout << std::setw(8) << "threads";
+  for (const auto &column : columns) {
+    std::cout << std::setw(16) << column;
+  }
+  std::cout << std::endl;
+}
+
+inline void PrintRow(size_t threads, const std::vector<double> &values) {
+  std::cout << std::setw(8) << threads;
+  for (double value : values) {
+    std::cout << std::setw(16) << std::fixed << std::setprecision(2)
+              << value / 1e6;
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace bench
+
+#endif  // BENCH_UTIL_H
@@ -0,0 +1,70 @@
+// locks::BlockQueue against the node-per-element locks::LinkedQueue.
+//
+// Single thread: bursts of kBurst enqueues followed by as many dequeues.
+// Contended: LinkedQueueThreadSafe on either queue, every thread enqueues
+// and then dequeues one element in a loop. Results are in Mops/s.
+//
+// Usage: block-queue-bench [threads...]
+
+#include "bench_util.h"
+#include "lock/block_queue.h"
+#include "lock/linked_queue.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+constexpr size_t kBurst = 1000;
+
+template <typename Queue>
+double BurstRate() {
+  Queue queue;
+  return bench::RunFor(1, kDuration, [&](size_t, const std::atomic_bool &stop) {
+    size_t ops = 0;
+    size_t value;
+    while (!stop.load(std::memory_order_relaxed)) {
+      for (size_t i = 0; i < kBurst; ++i) {
+        queue.Enqueue(size_t(i));
+      }
+      for (size_t i = 0; i < kBurst; ++i) {
+        queue.Dequeue(value);
+      }
+      ops += 2 * kBurst;
+    }
+    return ops;
+  });
+}
+
+template <typename Queue>
+double PairsRate(size_t threads) {
+  Queue queue;
+  return bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        size_t ops = 0;
+        size_t value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          queue.Enqueue(size_t(idx));
+          queue.TryDequeue(value);
+          ops += 2;
+        }
+        return ops;
+      });
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  bench::PrintHeader("single thread bursts, Mops/s", {"linked", "block"});
+  bench::PrintRow(1, {BurstRate<locks::LinkedQueue<size_t>>(),
+                      BurstRate<locks::BlockQueue<size_t>>()});
+
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+  bench::PrintHeader("enqueue+dequeue pairs under a mutex, Mops/s",
+                     {"linked", "block"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(
+        threads,
+        {PairsRate<locks::LinkedQueueThreadSafe<
+             size_t, std::mutex, locks::LinkedQueue<size_t>>>(threads),
+         PairsRate<locks::LinkedQueueThreadSafe<size_t>>(threads)});
+  }
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Michael-Scott queue versus flat combining at different contention
+// levels: every thread enqueues and dequeues one element, then does `work`
+// pause instructions of local work. Less work means more threads on the
+// queue at once. Results are in Mops/s.
+//
+// Usage: combining-bench [threads...]
+
+#include <memory>
+
+#include "bench_util.h"
+#include "lock-free/linked_queue.h"
+#include "lock/flat_combining_queue.h"
+#include "lock/lock_policies.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+const std::vector<size_t> kWork = {0, 100, 1000};
+
+typedef std::unique_ptr<int> Element;
+
+template <typename Queue>
+double PairsRate(size_t threads, size_t work) {
+  Queue queue(threads + 1);
+  double rate = bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        queue.RegisterThread();
+        size_t ops = 0;
+        Element value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          queue.Enqueue(std::make_unique<int>(idx));
+          queue.TryDequeue(value);
+          ops += 2;
+          for (size_t i = 0; i < work; ++i) {
+            locks::CpuRelax();
+          }
+        }
+        queue.UnregisterThread();
+        return ops;
+      });
+
+  queue.RegisterThread();
+  Element value;
+  while (queue.TryDequeue(value)) {
+  }
+  queue.UnregisterThread();
+  return rate;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts =
+      bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16, 32});
+
+  std::vector<std::string> columns;
+  for (size_t work : kWork) {
+    columns.push_back("MS w=" + std::to_string(work));
+    columns.push_back("FC w=" + std::to_string(work));
+  }
+
+  bench::PrintHeader("enqueue+dequeue pairs with w pauses of work, Mops/s",
+                     columns);
+  for (size_t threads : thread_counts) {
+    std::vector<double> rates;
+    for (size_t work : kWork) {
+      rates.push_back(
+          PairsRate<lock_free::LinkedQueue<Element>>(threads, work));
+      rates.push_back(
+          PairsRate<locks::FlatCombiningQueue<Element>>(threads, work));
+    }
+    bench::PrintRow(threads, rates);
+  }
+
+  return 0;
+}
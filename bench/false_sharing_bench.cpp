@@ -0,0 +1,173 @@
+// Before/after comparison of the cache line layout of the hot shared state:
+// every case runs the same access pattern on the old packed layout and on
+// the padded one used now. LinkedQueue, RingBuffer and HazardPointers are
+// the real types instantiated with both alignments (see kPackedAlign).
+// Results are in Mops/s.
+//
+// Usage: false-sharing-bench [threads...]
+
+#include <functional>
+
+#include "bench_util.h"
+#include "cache_line.h"
+#include "lock-free/hazard_pointers.h"
+#include "lock-free/linked_queue.h"
+#include "lock-free/ring_buffer.h"
+#include "sharded_counter.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+
+// Every thread enqueues and dequeues in turn, so producers and consumers
+// hit head_, tail_ and their hazard pointer rows at the same time.
+template <size_t kAlign>
+double LinkedQueueRate(size_t threads) {
+  static int element;
+  lock_free::LinkedQueue<int *, kAlign> queue(threads);
+  return bench::RunFor(threads, kDuration,
+                       [&](size_t, const std::atomic_bool &stop) {
+                         queue.RegisterThread();
+                         int *data;
+                         size_t ops = 0;
+                         while (!stop.load(std::memory_order_relaxed)) {
+                           queue.Enqueue(&element);
+                           queue.TryDequeue(data);
+                           ops += 2;
+                         }
+                         queue.UnregisterThread();
+                         return ops;
+                       });
+}
+
+// As above: the enqueue side works on tail_idx_ and free_, the dequeue
+// side on head_idx_ and used_.
+template <size_t kAlign>
+double RingBufferRate(size_t threads) {
+  lock_free::RingBuffer<size_t, kAlign> ring(1024);
+  return bench::RunFor(threads, kDuration,
+                       [&](size_t idx, const std::atomic_bool &stop) {
+                         size_t data = idx;
+                         size_t ops = 0;
+                         while (!stop.load(std::memory_order_relaxed)) {
+                           ops += ring.TryEnqueue(std::move(data));
+                           ops += ring.TryDequeue(data);
+                         }
+                         return ops;
+                       });
+}
+
+// Every thread publishes and clears its own hazard pointer row, as each
+// queue operation does.
+template <size_t kAlign>
+double HazardRowsRate(size_t threads) {
+  struct Node {};
+  Node node;
+  lock_free::HazardPointers<Node, HP_PER_THREAD, kAlign> hp(threads);
+  return bench::RunFor(threads, kDuration,
+                       [&](size_t, const std::atomic_bool &stop) {
+                         hp.AddThread();
+                         size_t ops = 0;
+                         while (!stop.load(std::memory_order_relaxed)) {
+                           hp.AcquireHazardPointer(0, &node);
+                           hp.AcquireHazardPointer(1, &node);
+                           hp.ReleaseHazardPointer(0);
+                           hp.ReleaseHazardPointer(1);
+                           ++ops;
+                         }
+                         hp.RemoveThread();
+                         return ops;
+                       });
+}
+
+struct PackedFlag {
+  std::atomic_bool need_stop;
+  std::atomic_size_t idle_threads;
+};
+
+struct PaddedFlag {
+  alignas(kCacheLineSize) std::atomic_bool need_stop;
+  alignas(kCacheLineSize) std::atomic_size_t idle_threads;
+};
+
+// One thread keeps updating a counter while the others poll the stop flag,
+// like idle workers of the thread pool do.
+template <typename Flag>
+double StopFlagRate(size_t threads) {
+  Flag flag{};
+  return bench::RunFor(threads + 1, kDuration,
+                       [&](size_t idx, const std::atomic_bool &stop) {
+                         size_t ops = 0;
+                         if (idx == 0) {
+                           while (!stop.load(std::memory_order_relaxed)) {
+                             flag.idle_threads.fetch_add(1);
+                           }
+                           return ops;
+                         }
+                         while (!stop.load(std::memory_order_relaxed)) {
+                           if (flag.need_stop.load()) {
+                             break;
+                           }
+                           ++ops;
+                         }
+                         return ops;
+                       });
+}
+// Every thread counts completed tasks, as the task bodies do.
+struct SharedCounter {
+  std::atomic_uint64_t value = 0;
+  void Add() { value.fetch_add(1, std::memory_order_relaxed); }
+};
+
+template <typename Counter>
+double TaskCounterRate(size_t threads) {
+  Counter counter;
+  return bench::RunFor(threads, kDuration,
+                       [&](size_t, const std::atomic_bool &stop) {
+                         size_t ops = 0;
+                         while (!stop.load(std::memory_order_relaxed)) {
+                           counter.Add();
+                           ++ops;
+                         }
+                         return ops;
+                       });
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(
+      argc, argv, {1, 2, 4, 8, 16, static_cast<size_t>(MAX_THREAD_NUM / 2)});
+
+  bench::PrintHeader("lock_free::LinkedQueue, Mops/s", {"packed", "padded"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(threads, {LinkedQueueRate<kPackedAlign>(threads),
+                              LinkedQueueRate<kCacheLineSize>(threads)});
+  }
+
+  bench::PrintHeader("lock_free::RingBuffer, Mops/s", {"packed", "padded"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(threads, {RingBufferRate<kPackedAlign>(threads),
+                              RingBufferRate<kCacheLineSize>(threads)});
+  }
+
+  bench::PrintHeader("lock_free::HazardPointers rows, Mops/s",
+                     {"packed", "padded"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(threads, {HazardRowsRate<kPackedAlign>(threads),
+                              HazardRowsRate<kCacheLineSize>(threads)});
+  }
+
+  bench::PrintHeader("stop flag polls next to a written counter, Mops/s",
+                     {"packed", "padded"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(threads, {StopFlagRate<PackedFlag>(threads),
+                              StopFlagRate<PaddedFlag>(threads)});
+  }
+
+  bench::PrintHeader("task counter, Mops/s", {"shared", "sharded"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(threads, {TaskCounterRate<SharedCounter>(threads),
+                              TaskCounterRate<ShardedCounter>(threads)});
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+// Throughput of lock_free::HashMap against std::unordered_map under one
+// std::mutex, for a read-heavy (90% Find, 5% InsertOrAssign, 5% Erase)
+// and a write-heavy (50/25/25) mix over kKeys keys, prefilled to half.
+// Results are in Mops/s.
+//
+// Usage: hash-map-bench [threads...]
+
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include "bench_util.h"
+#include "lock-free/hash_map.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+constexpr uint64_t kKeys = 1 << 16;
+
+struct Mix {
+  const char *name;
+  unsigned find_percent;
+  unsigned insert_percent;
+};
+
+class LockedMap {
+ public:
+  LockedMap(size_t) {}
+  void RegisterThread() {}
+  void UnregisterThread() {}
+
+  bool Find(uint64_t key, uint64_t &value) {
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  bool InsertOrAssign(uint64_t key, uint64_t value) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return map_.insert_or_assign(key, value).second;
+  }
+
+  bool Erase(uint64_t key) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return map_.erase(key) != 0;
+  }
+
+ private:
+  std::mutex lock_;
+  std::unordered_map<uint64_t, uint64_t> map_;
+};
+
+template <typename Map>
+double MixRate(size_t threads, const Mix &mix) {
+  Map map(threads + 1);
+  map.RegisterThread();
+  for (uint64_t key = 0; key < kKeys; key += 2) {
+    map.InsertOrAssign(key, key);
+  }
+  map.UnregisterThread();
+
+  return bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        map.RegisterThread();
+        std::minstd_rand engine(idx + 1);
+        size_t ops = 0;
+        uint64_t value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          uint64_t key = engine() % kKeys;
+          unsigned op = engine() % 100;
+          if (op < mix.find_percent) {
+            map.Find(key, value);
+          } else if (op < mix.find_percent + mix.insert_percent) {
+            map.InsertOrAssign(key, key);
+          } else {
+            map.Erase(key);
+          }
+          ++ops;
+        }
+        map.UnregisterThread();
+        return ops;
+      });
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+
+  for (const Mix &mix : {Mix{"read-heavy 90/5/5", 90, 5},
+                         Mix{"write-heavy 50/25/25", 50, 25}}) {
+    bench::PrintHeader(std::string(mix.name) + ", Mops/s",
+                       {"lock-free", "mutex"});
+    for (size_t threads : thread_counts) {
+      bench::PrintRow(
+          threads,
+          {MixRate<lock_free::HashMap<uint64_t, uint64_t>>(threads, mix),
+           MixRate<LockedMap>(threads, mix)});
+    }
+  }
+
+  return 0;
+}
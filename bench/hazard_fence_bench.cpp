@@ -0,0 +1,72 @@
+// Per-operation cost of lock_free::LinkedQueue::TryDequeue with symmetric
+// (seq_cst fence per hazard pointer publish) and asymmetric (compiler fence
+// per publish, membarrier per scan) hazard pointer fences.
+//
+// Usage: hazard-fence-bench [threads...]
+
+#include <memory>
+
+#include "bench_util.h"
+#include "lock-free/asymmetric_fence.h"
+#include "lock-free/linked_queue.h"
+
+namespace {
+constexpr size_t kElementsPerThread = 200000;
+
+typedef std::unique_ptr<int> Element;
+
+// Prefills the queue and lets `threads` threads drain it, returns ns/op.
+double DequeueCost(size_t threads) {
+  lock_free::LinkedQueue<Element> queue(threads + 1);
+  queue.RegisterThread();
+  size_t total = kElementsPerThread * threads;
+  for (size_t i = 0; i < total; ++i) {
+    queue.Enqueue(std::make_unique<int>(i));
+  }
+
+  double seconds = bench::RunOnce(threads, [&](size_t) {
+    queue.RegisterThread();
+    Element value;
+    while (queue.TryDequeue(value)) {
+    }
+    queue.UnregisterThread();
+  });
+  queue.UnregisterThread();
+
+  return seconds * 1e9 * threads / total;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+
+  std::vector<double> symmetric;
+  lock_free::AsymmetricFence::SetMode(lock_free::FenceMode::kSymmetric);
+  for (size_t threads : thread_counts) {
+    symmetric.push_back(DequeueCost(threads));
+  }
+
+  std::vector<double> asymmetric;
+  bool available = lock_free::AsymmetricFence::SetMode(
+                       lock_free::FenceMode::kAsymmetric) ==
+                   lock_free::FenceMode::kAsymmetric;
+  for (size_t threads : thread_counts) {
+    asymmetric.push_back(DequeueCost(threads));
+  }
+
+  if (!available) {
+    std::cout << "membarrier is not available, asymmetric mode fell back to "
+                 "symmetric fences"
+              << std::endl;
+  }
+  std::cout << std::endl << "TryDequeue cost, ns/op" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(16) << "symmetric"
+            << std::setw(16) << "asymmetric" << std::endl;
+  for (size_t i = 0; i < thread_counts.size(); ++i) {
+    std::cout << std::setw(8) << thread_counts[i] << std::setw(16)
+              << std::fixed << std::setprecision(1) << symmetric[i]
+              << std::setw(16) << asymmetric[i] << std::endl;
+  }
+
+  return 0;
+}
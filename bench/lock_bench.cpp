@@ -0,0 +1,94 @@
+// Throughput of locks::LinkedQueueThreadSafe with every lock policy, and
+// how long threads waited for the lock. Every thread enqueues and then
+// dequeues one element in a loop.
+//
+// Usage: lock-bench [threads...]
+
+#include <memory>
+#include <sstream>
+
+#include "bench_util.h"
+#include "lock/linked_queue.h"
+#include "lock/lock_policies.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+
+typedef std::unique_ptr<int> Element;
+
+struct LockResult {
+  double rate = 0;
+  double contended = 0;    // share of contended acquisitions
+  double mean_wait = 0;    // ns per acquisition
+};
+
+template <typename Lock>
+LockResult Measure(size_t threads) {
+  locks::LinkedQueueThreadSafe<Element, Lock> queue;
+  LockResult result;
+  result.rate = bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        size_t ops = 0;
+        Element value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          queue.Enqueue(std::make_unique<int>(idx));
+          queue.TryDequeue(value);
+          ops += 2;
+        }
+        return ops;
+      });
+
+  const locks::LockStats &stats = queue.GetLock().GetStats();
+  if (stats.GetAcquisitions() > 0) {
+    result.contended =
+        static_cast<double>(stats.GetContended()) / stats.GetAcquisitions();
+    result.mean_wait =
+        static_cast<double>(stats.GetWaitNs()) / stats.GetAcquisitions();
+  }
+  return result;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+  const std::vector<std::string> columns = {"mutex", "ttas", "ticket", "mcs",
+                                            "spin-futex"};
+
+  std::vector<std::vector<LockResult>> results;
+  for (size_t threads : thread_counts) {
+    results.push_back({Measure<locks::MutexLock>(threads),
+                       Measure<locks::TtasLock>(threads),
+                       Measure<locks::TicketLock>(threads),
+                       Measure<locks::McsLock>(threads),
+                       Measure<locks::SpinFutexLock>(threads)});
+  }
+
+  bench::PrintHeader("enqueue+dequeue pairs, Mops/s", columns);
+  for (size_t i = 0; i < thread_counts.size(); ++i) {
+    std::vector<double> rates;
+    for (const auto &result : results[i]) {
+      rates.push_back(result.rate);
+    }
+    bench::PrintRow(thread_counts[i], rates);
+  }
+
+  std::cout << std::endl
+            << "lock wait per acquisition, ns (contended %)" << std::endl;
+  std::cout << std::setw(8) << "threads";
+  for (const auto &column : columns) {
+    std::cout << std::setw(16) << column;
+  }
+  std::cout << std::endl;
+  for (size_t i = 0; i < thread_counts.size(); ++i) {
+    std::cout << std::setw(8) << thread_counts[i];
+    for (const auto &result : results[i]) {
+      std::ostringstream cell;
+      cell << std::fixed << std::setprecision(1) << result.mean_wait << " ("
+           << std::setprecision(0) << result.contended * 100 << "%)";
+      std::cout << std::setw(16) << cell.str();
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
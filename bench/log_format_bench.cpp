@@ -0,0 +1,130 @@
+// Records formatted per second by one logger thread for the task log
+// record (four doubles and an integer):
+//   stream  - the message built with operator<< into a std::stringstream
+//             and the record with an std::ostringstream and std::put_time,
+//             as serializeLogMeassage first did
+//   pattern - encoded arguments formatted by a compiled LogPattern into a
+//             reused string
+//   binary  - encoded arguments written by a BinaryLogWriter
+// Every thread formats its own records. Results are in Mrecords/s.
+//
+// Usage: log-format-bench [threads...]
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "bench_util.h"
+#include "binary_log.h"
+#include "log_format.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(300);
+constexpr size_t kValues = 1024;
+
+constinit LogSite task_site(
+    LogLevel::kInfo, "/root/repo/src/task_generator.cpp", 137,
+    "a: {}, b: {}, num: {}, result: {}, execution time: {}ms");
+
+struct Task {
+  double a;
+  double b;
+  size_t num;
+  double result;
+  double ms;
+};
+
+std::vector<Task> MakeTasks() {
+  std::vector<Task> tasks;
+  for (size_t i = 0; i < kValues; ++i) {
+    double a = static_cast<double>(rand()) / RAND_MAX;
+    double b = static_cast<double>(rand()) / RAND_MAX;
+    tasks.push_back({a, b, i * 7919, std::cos(a) - std::cos(b),
+                     10.0 + static_cast<double>(rand()) / RAND_MAX});
+  }
+  return tasks;
+}
+
+size_t Stream(const std::vector<Task> &tasks, std::atomic_bool &stop) {
+  size_t n = 0;
+  std::stringstream smsg;
+  while (!stop.load(std::memory_order_relaxed)) {
+    const Task &task = tasks[n % kValues];
+    smsg.str("");
+    smsg << "a: " << task.a << ", b: " << task.b << ", num: " << task.num
+         << ", result: " << task.result << ", execution time: " << task.ms
+         << "ms";
+
+    time_t time = 1700000000 + n / 1000;
+    std::ostringstream record_stream;
+    record_stream << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S")
+                  << "  " << LogLevelName(task_site.GetLevel()) << " "
+                  << task_site.GetFile() << ":" << task_site.GetLine() << " "
+                  << smsg.str() << std::endl;
+    std::string record = record_stream.str();
+    ++n;
+  }
+  return n;
+}
+
+template <typename Serialize>
+size_t Encoded(const std::vector<Task> &tasks, std::atomic_bool &stop,
+               Serialize serialize) {
+  size_t n = 0;
+  std::string args;
+  std::string record;
+  while (!stop.load(std::memory_order_relaxed)) {
+    const Task &task = tasks[n % kValues];
+    args.clear();
+    AppendLogArg(args, task.a);
+    AppendLogArg(args, task.b);
+    AppendLogArg(args, task.num);
+    AppendLogArg(args, task.result);
+    AppendLogArg(args, task.ms);
+    serialize(1700000000 + n / 1000, args, record);
+    ++n;
+  }
+  return n;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4});
+  const std::vector<Task> tasks = MakeTasks();
+  const LogPattern pattern;
+
+  bench::PrintHeader("task log records, Mrecords/s",
+                     {"stream", "pattern", "binary"});
+  for (size_t threads : thread_counts) {
+    double stream = bench::RunFor(threads, kDuration,
+                                  [&](size_t, std::atomic_bool &stop) {
+                                    return Stream(tasks, stop);
+                                  });
+    double text = bench::RunFor(
+        threads, kDuration, [&](size_t, std::atomic_bool &stop) {
+          LogTimeFormatter time_formatter;
+          return Encoded(tasks, stop,
+                         [&](time_t time, const std::string &args,
+                             std::string &record) {
+                           pattern.Format(
+                               time_formatter,
+                               {time, task_site.GetLevel(),
+                                task_site.GetFile(), task_site.GetLine(),
+                                task_site.GetFormat(), args},
+                               record);
+                         });
+        });
+    double binary = bench::RunFor(
+        threads, kDuration, [&](size_t, std::atomic_bool &stop) {
+          BinaryLogWriter writer;
+          return Encoded(tasks, stop,
+                         [&](time_t time, const std::string &args,
+                             std::string &record) {
+                           writer.Write(time, task_site, args, record);
+                         });
+        });
+    bench::PrintRow(threads, {stream, text, binary});
+  }
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Throughput versus ordering quality of locks::MultiQueue with c = 1, 2
+// and 4 sub-queues per thread.
+//
+// Throughput: every thread enqueues and then dequeues one element in a
+// loop. Ordering: the queue is prefilled with 0..N-1 and drained by all
+// threads; the rank error of a dequeued element is the distance between
+// its value and its position in the global dequeue order.
+//
+// Usage: multiqueue-bench [threads...]
+
+#include <memory>
+#include <sstream>
+
+#include "bench_util.h"
+#include "lock/multi_queue.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+constexpr size_t kPrefill = 200000;
+const std::vector<size_t> kQueuesPerThread = {1, 2, 4};
+
+double PairsRate(size_t threads, size_t queues_per_thread) {
+  locks::MultiQueue<size_t> queue(threads, queues_per_thread);
+  return bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        size_t ops = 0;
+        size_t value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          queue.Enqueue(std::move(idx));
+          queue.TryDequeue(value);
+          ops += 2;
+        }
+        return ops;
+      });
+}
+
+struct RankError {
+  double mean = 0;
+  size_t max = 0;
+};
+
+RankError DrainRankError(size_t threads, size_t queues_per_thread) {
+  locks::MultiQueue<size_t> queue(threads, queues_per_thread);
+  for (size_t i = 0; i < kPrefill; ++i) {
+    queue.Enqueue(size_t(i));
+  }
+
+  std::atomic_size_t position = 0;
+  std::atomic_size_t total_error = 0;
+  std::atomic_size_t max_error = 0;
+  bench::RunOnce(threads, [&](size_t) {
+    size_t value;
+    size_t sum = 0;
+    size_t max = 0;
+    while (queue.TryDequeue(value)) {
+      size_t pos = position.fetch_add(1, std::memory_order_relaxed);
+      size_t error = pos > value ? pos - value : value - pos;
+      sum += error;
+      max = std::max(max, error);
+    }
+    total_error += sum;
+    size_t current = max_error.load();
+    while (current < max && !max_error.compare_exchange_weak(current, max)) {
+    }
+  });
+
+  return {static_cast<double>(total_error) / kPrefill, max_error};
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+
+  std::vector<std::string> columns;
+  for (size_t c : kQueuesPerThread) {
+    columns.push_back("c=" + std::to_string(c));
+  }
+
+  bench::PrintHeader("enqueue+dequeue pairs, Mops/s", columns);
+  for (size_t threads : thread_counts) {
+    std::vector<double> rates;
+    for (size_t c : kQueuesPerThread) {
+      rates.push_back(PairsRate(threads, c));
+    }
+    bench::PrintRow(threads, rates);
+  }
+
+  std::cout << std::endl << "rank error, mean (max)" << std::endl;
+  std::cout << std::setw(8) << "threads";
+  for (const auto &column : columns) {
+    std::cout << std::setw(16) << column;
+  }
+  std::cout << std::endl;
+  for (size_t threads : thread_counts) {
+    std::cout << std::setw(8) << threads;
+    for (size_t c : kQueuesPerThread) {
+      RankError error = DrainRankError(threads, c);
+      std::ostringstream cell;
+      cell << std::fixed << std::setprecision(1) << error.mean << " ("
+           << error.max << ")";
+      std::cout << std::setw(16) << cell.str();
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
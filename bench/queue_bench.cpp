@@ -0,0 +1,80 @@
+// MPMC throughput of the queue implementations: every thread enqueues and
+// then dequeues one element in a loop. Results are in Mops/s.
+//
+// Usage: queue-bench [threads...]
+
+#include <memory>
+
+#include "bench_util.h"
+#include "lock-free/faa_queue.h"
+#include "lock-free/linked_queue.h"
+#include "lock/flat_combining_queue.h"
+#include "lock/linked_queue.h"
+#include "lock/multi_queue.h"
+#include "lock/two_lock_queue.h"
+
+namespace {
+constexpr std::chrono::milliseconds kDuration(200);
+
+typedef std::unique_ptr<int> Element;
+
+template <typename Queue>
+void RegisterThread(Queue &queue) {
+  if constexpr (requires { queue.RegisterThread(); }) {
+    queue.RegisterThread();
+  }
+}
+
+template <typename Queue>
+void UnregisterThread(Queue &queue) {
+  if constexpr (requires { queue.UnregisterThread(); }) {
+    queue.UnregisterThread();
+  }
+}
+
+template <typename Queue, typename... Args>
+double PairsRate(size_t threads, Args &&...args) {
+  Queue queue(std::forward<Args>(args)...);
+  double rate = bench::RunFor(
+      threads, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        RegisterThread(queue);
+        size_t ops = 0;
+        Element value;
+        while (!stop.load(std::memory_order_relaxed)) {
+          queue.Enqueue(std::make_unique<int>(idx));
+          queue.TryDequeue(value);
+          ops += 2;
+        }
+        UnregisterThread(queue);
+        return ops;
+      });
+
+  RegisterThread(queue);
+  Element value;
+  while (queue.TryDequeue(value)) {
+  }
+  UnregisterThread(queue);
+  return rate;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts =
+      bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16, 32});
+
+  bench::PrintHeader("enqueue+dequeue pairs, Mops/s",
+                     {"lock-free MS", "lock-free FAA", "locks linked",
+                      "locks two-lock", "multiqueue", "flat combining"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(
+        threads,
+        {PairsRate<lock_free::LinkedQueue<Element>>(threads, threads + 1),
+         PairsRate<lock_free::FaaArrayQueue<Element>>(threads, threads + 1),
+         PairsRate<locks::LinkedQueueThreadSafe<Element>>(threads),
+         PairsRate<locks::TwoLockQueue<Element>>(threads),
+         PairsRate<locks::MultiQueue<Element>>(threads, threads),
+         PairsRate<locks::FlatCombiningQueue<Element>>(threads)});
+  }
+
+  return 0;
+}
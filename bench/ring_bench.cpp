@@ -0,0 +1,66 @@
+// Hand-off rate of the lock_free::BoundedRing specializations: thread 0
+// consumes, the other threads produce, the rate is elements received by
+// the consumer. With one producer all topologies are valid, so the table
+// shows what each relaxation costs over the SPSC ring; with several
+// producers only MPSC and MPMC remain.
+//
+// Usage: ring-bench [producers...]
+
+#include "bench_util.h"
+#include "lock-free/bounded_ring.h"
+
+namespace {
+using lock_free::BoundedRing;
+using lock_free::Consumers;
+using lock_free::Producers;
+
+constexpr std::chrono::milliseconds kDuration(200);
+constexpr size_t kCapacity = 1024;
+
+template <typename Ring>
+double HandOffRate(size_t producers) {
+  Ring ring(kCapacity);
+  return bench::RunFor(
+      producers + 1, kDuration, [&](size_t idx, const std::atomic_bool &stop) {
+        size_t received = 0;
+        size_t value = idx;
+        while (!stop.load(std::memory_order_relaxed)) {
+          if (idx == 0) {
+            received += ring.TryDequeue(value);
+          } else {
+            ring.Enqueue(size_t(value));
+          }
+        }
+        return received;
+      });
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  bench::PrintHeader("1 producer, 1 consumer, Mops/s",
+                     {"SPSC", "SPSC static", "MPSC", "SPMC", "MPMC"});
+  bench::PrintRow(
+      1,
+      {HandOffRate<BoundedRing<size_t, Producers::kSingle,
+                               Consumers::kSingle>>(1),
+       HandOffRate<BoundedRing<size_t, Producers::kSingle, Consumers::kSingle,
+                               kCapacity>>(1),
+       HandOffRate<BoundedRing<size_t, Producers::kMulti,
+                               Consumers::kSingle>>(1),
+       HandOffRate<BoundedRing<size_t, Producers::kSingle,
+                               Consumers::kMulti>>(1),
+       HandOffRate<BoundedRing<size_t, Producers::kMulti,
+                               Consumers::kMulti>>(1)});
+
+  auto producer_counts = bench::ParseThreadCounts(argc, argv, {2, 4, 8});
+  bench::PrintHeader("N producers, 1 consumer, Mops/s", {"MPSC", "MPMC"});
+  for (size_t producers : producer_counts) {
+    bench::PrintRow(producers,
+                    {HandOffRate<BoundedRing<size_t, Producers::kMulti,
+                                             Consumers::kSingle>>(producers),
+                     HandOffRate<BoundedRing<size_t, Producers::kMulti,
+                                             Consumers::kMulti>>(producers)});
+  }
+
+  return 0;
+}
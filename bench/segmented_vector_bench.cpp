@@ -0,0 +1,57 @@
+// lock_free::SegmentedVector against a std::vector under a mutex: every
+// thread appends kPushes / threads elements, as the tasks of a pass store
+// their results. Results are in Mpushes/s.
+//
+// Usage: segmented-vector-bench [threads...]
+
+#include <mutex>
+#include <vector>
+
+#include "bench_util.h"
+#include "lock-free/segmented_vector.h"
+
+namespace {
+constexpr size_t kPushes = 4000000;
+
+struct Result {
+  size_t num;
+  double value;
+};
+
+class LockedVector {
+ public:
+  void PushBack(Result &&result) {
+    std::unique_lock<std::mutex> lock(lock_);
+    results_.push_back(result);
+  }
+
+ private:
+  std::mutex lock_;
+  std::vector<Result> results_;
+};
+
+template <typename Vector>
+double PushRate(size_t threads) {
+  Vector vector;
+  size_t per_thread = kPushes / threads;
+  double seconds = bench::RunOnce(threads, [&](size_t idx) {
+    for (size_t i = 0; i < per_thread; ++i) {
+      vector.PushBack(Result{idx * per_thread + i, 0.5});
+    }
+  });
+  return per_thread * threads / seconds;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto thread_counts = bench::ParseThreadCounts(argc, argv, {1, 2, 4, 8, 16});
+
+  bench::PrintHeader("concurrent appends, Mpushes/s", {"locked", "segmented"});
+  for (size_t threads : thread_counts) {
+    bench::PrintRow(
+        threads, {PushRate<LockedVector>(threads),
+                  PushRate<lock_free::SegmentedVector<Result>>(threads)});
+  }
+
+  return 0;
+}
@@ -0,0 +1,279 @@
+#ifndef ADAPTIVE_QUEUE_H
+#define ADAPTIVE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+#include "lock-free/linked_queue.h"
+#include "lock/lock_policies.h"
+#include "sharded_counter.h"
+
+enum class QueueMode { kLock, kLockFree };
+
+inline const char *QueueModeName(QueueMode mode) {
+  return mode == QueueMode::kLock ? "lock" : "lock-free";
+}
+
+// When AdaptiveQueue switches. Both directions need `windows` windows in a
+// row past their threshold, a window ending whenever a thread completes
+// `window_ops` operations of its own, and the thresholds are far apart, so
+// a load near one of them does not make the queue flip back and forth.
+struct AdaptivePolicy {
+  QueueMode initial_mode = QueueMode::kLock;
+  uint64_t window_ops = 4096;
+  uint32_t windows = 4;
+  // Lock -> lock-free: mean wait per lock acquisition.
+  uint64_t max_lock_wait_ns = 1000;
+  // Lock-free -> lock: failed CASes per operation.
+  double min_cas_failure_rate = 0.02;
+};
+
+struct QueueModeTransition {
+  std::chrono::steady_clock::duration at;  // since construction
+  QueueMode mode;                          // the new mode
+};
+
+// Queue that runs either as a std::deque under a mutex, which is cheapest
+// with few threads, or as lock_free::LinkedQueue, which holds up better
+// under contention, and migrates between them at run time.
+//
+// Every operation enters a gate: it increments the in-flight count of its
+// thread's shard (see ThreadShard), checks that no switch is in progress
+// and decrements the count when done. A switch raises kSwitching, waits
+// until every shard is at zero, moves the elements to the other backend in
+// FIFO order and flips the mode; operations arriving meanwhile wait for
+// it. Shards are cache-line padded, so the gate touches a line the thread
+// normally has to itself and the only shared line, state_, is read-only
+// between switches.
+//
+// Shards also count operations: a thread that completes window_ops
+// operations of its own evaluates the window, the operations of all
+// threads since the last evaluation, against the policy, so no extra
+// thread is needed.
+template <typename T>
+class AdaptiveQueue {
+ public:
+  typedef T value_type;
+
+  // tnum is the expected number of threads, for the lock-free backend.
+  AdaptiveQueue(size_t tnum, AdaptivePolicy policy = AdaptivePolicy())
+      : policy_(policy),
+        start_(std::chrono::steady_clock::now()),
+        lock_free_queue_(tnum),
+        state_(policy.initial_mode == QueueMode::kLockFree ? kLockFreeMode
+                                                            : 0) {}
+
+  AdaptiveQueue(const AdaptiveQueue &) = delete;
+
+  // Threads register with the lock-free backend in both modes, so a switch
+  // does not need them.
+  void RegisterThread() { lock_free_queue_.RegisterThread(); }
+  void UnregisterThread() { lock_free_queue_.UnregisterThread(); }
+
+  bool Enqueue(T &&data) { return Emplace(std::move(data)); }
+
+  template <typename... Args>
+  bool Emplace(Args &&...args) {
+    Gate &gate = Enter();
+    if (Mode() == QueueMode::kLock) {
+      std::unique_lock<locks::MutexLock> lock(lock_);
+      queue_.emplace_back(std::forward<Args>(args)...);
+    } else {
+      lock_free_queue_.Emplace(std::forward<Args>(args)...);
+    }
+    Leave(gate);
+    return true;
+  }
+
+  bool TryDequeue(T &data) {
+    Gate &gate = Enter();
+    bool res;
+    if (Mode() == QueueMode::kLock) {
+      std::unique_lock<locks::MutexLock> lock(lock_);
+      res = !queue_.empty();
+      if (res) {
+        data = std::move(queue_.front());
+        queue_.pop_front();
+      }
+    } else {
+      res = lock_free_queue_.TryDequeue(data);
+    }
+    Leave(gate);
+    return res;
+  }
+
+  QueueMode Mode() const {
+    return (state_.load(std::memory_order_relaxed) & kLockFreeMode) != 0
+               ? QueueMode::kLockFree
+               : QueueMode::kLock;
+  }
+
+  // Moves to `mode` now, regardless of the policy. The calling thread
+  // must be registered and not inside an operation.
+  void SwitchTo(QueueMode mode) {
+    uint32_t state = state_.load();
+    do {
+      if ((state & kSwitching) != 0 || ToMode(state) == mode) {
+        return;
+      }
+    } while (!state_.compare_exchange_weak(state, state | kSwitching));
+
+    while (!Quiescent()) {
+      std::this_thread::yield();
+    }
+    if (mode == QueueMode::kLockFree) {
+      for (auto &element : queue_) {
+        lock_free_queue_.Enqueue(std::move(element));
+      }
+      queue_.clear();
+    } else {
+      T data;
+      while (lock_free_queue_.TryDequeue(data)) {
+        queue_.push_back(std::move(data));
+      }
+    }
+    transitions_.push_back({std::chrono::steady_clock::now() - start_, mode});
+
+    state_.store(mode == QueueMode::kLockFree ? kLockFreeMode : 0);
+  }
+
+  // Stats of the lock of the lock mode.
+  locks::LockStatsTotal GetLockStats() const {
+    locks::LockStatsTotal total;
+    total.Add(lock_.GetStats());
+    return total;
+  }
+
+  // Read once the queue is no longer used.
+  const std::vector<QueueModeTransition> &GetTransitions() const {
+    return transitions_;
+  }
+
+ private:
+  static constexpr uint32_t kLockFreeMode = 1;
+  static constexpr uint32_t kSwitching = 2;
+
+  const AdaptivePolicy policy_;
+  const std::chrono::steady_clock::time_point start_;
+
+  alignas(kCacheLineSize) locks::MutexLock lock_;
+  std::deque<T> queue_;
+
+  alignas(kCacheLineSize) lock_free::LinkedQueue<T> lock_free_queue_;
+
+  struct alignas(kCacheLineSize) Gate {
+    std::atomic_uint64_t in_flight = 0;  // operations inside the queue
+    std::atomic_uint64_t ops = 0;        // operations done
+  };
+
+  alignas(kCacheLineSize) std::atomic_uint32_t state_;
+  Gate gates_[kCounterShards];
+
+  // Window bookkeeping, touched by the evaluating thread only.
+  alignas(kCacheLineSize) std::atomic_flag evaluating_;
+  uint64_t window_acquisitions_ = 0;
+  uint64_t window_wait_ns_ = 0;
+  uint64_t window_cas_failures_ = 0;
+  uint64_t window_ops_ = 0;
+  uint32_t votes_ = 0;
+  // Written by the switching thread only.
+  std::vector<QueueModeTransition> transitions_;
+
+  static QueueMode ToMode(uint32_t state) {
+    return (state & kLockFreeMode) != 0 ? QueueMode::kLockFree
+                                        : QueueMode::kLock;
+  }
+
+  // The seq_cst in_flight increment and state_ load pair with the state_
+  // CAS and the in_flight loads in SwitchTo: either the operation sees the
+  // switch and backs off or the switch waits for the operation.
+  Gate &Enter() {
+    Gate &gate = gates_[ThreadShard()];
+    while (true) {
+      gate.in_flight.fetch_add(1);
+      if ((state_.load() & kSwitching) == 0) {
+        return gate;
+      }
+      gate.in_flight.fetch_sub(1);
+      while ((state_.load() & kSwitching) != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void Leave(Gate &gate) {
+    gate.in_flight.fetch_sub(1, std::memory_order_release);
+    uint64_t op = gate.ops.fetch_add(1, std::memory_order_relaxed);
+    if ((op + 1) % policy_.window_ops == 0) {
+      Evaluate();
+    }
+  }
+
+  // A shard may read non-zero for a moment while an operation that came
+  // after the switch backs off; the switch then just looks again.
+  bool Quiescent() const {
+    for (const Gate &gate : gates_) {
+      if (gate.in_flight.load() != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t Ops() const {
+    uint64_t ops = 0;
+    for (const Gate &gate : gates_) {
+      ops += gate.ops.load(std::memory_order_relaxed);
+    }
+    return ops;
+  }
+
+  void ResetWindow() {
+    const locks::LockStats &stats = lock_.GetStats();
+    window_acquisitions_ = stats.GetAcquisitions();
+    window_wait_ns_ = stats.GetWaitNs();
+    window_cas_failures_ = lock_free_queue_.GetCasFailures();
+    window_ops_ = Ops();
+  }
+
+  void Evaluate() {
+    if (evaluating_.test_and_set(std::memory_order_acquire)) {
+      return;
+    }
+
+    const locks::LockStats &stats = lock_.GetStats();
+    uint64_t acquisitions = stats.GetAcquisitions() - window_acquisitions_;
+    uint64_t wait_ns = stats.GetWaitNs() - window_wait_ns_;
+    uint64_t cas_failures =
+        lock_free_queue_.GetCasFailures() - window_cas_failures_;
+    uint64_t ops = Ops() - window_ops_;
+    ResetWindow();
+
+    bool vote;
+    if (Mode() == QueueMode::kLock) {
+      vote = acquisitions != 0 &&
+             wait_ns >= policy_.max_lock_wait_ns * acquisitions;
+    } else {
+      vote = ops != 0 && static_cast<double>(cas_failures) <
+                             policy_.min_cas_failure_rate * ops;
+    }
+    votes_ = vote ? votes_ + 1 : 0;
+    if (votes_ >= policy_.windows) {
+      SwitchTo(Mode() == QueueMode::kLock ? QueueMode::kLockFree
+                                          : QueueMode::kLock);
+      votes_ = 0;
+      ResetWindow();
+    }
+
+    evaluating_.clear(std::memory_order_release);
+  }
+};
+
+#endif  // ADAPTIVE_QUEUE_H
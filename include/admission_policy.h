@@ -0,0 +1,51 @@
+#ifndef ADMISSION_POLICY_H
+#define ADMISSION_POLICY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// What a bounded queue does with a new element when it is full.
+enum class AdmissionPolicy {
+  kBlock,       // wait until a consumer frees a place
+  kReject,      // fail fast, the element is left to the caller
+  kDropOldest,  // evict the oldest element to make room
+  kCallerRuns   // fail fast, the caller runs the task on its own thread
+};
+
+inline const char *AdmissionPolicyName(AdmissionPolicy policy) {
+  switch (policy) {
+    case AdmissionPolicy::kBlock:
+      return "block";
+    case AdmissionPolicy::kReject:
+      return "reject";
+    case AdmissionPolicy::kDropOldest:
+      return "drop_oldest";
+    case AdmissionPolicy::kCallerRuns:
+      return "caller_runs";
+  }
+  return "unknown";
+}
+
+// Returns false if `name` is not a known policy.
+inline bool ParseAdmissionPolicy(const std::string &name,
+                                 AdmissionPolicy &policy) {
+  for (AdmissionPolicy p :
+       {AdmissionPolicy::kBlock, AdmissionPolicy::kReject,
+        AdmissionPolicy::kDropOldest, AdmissionPolicy::kCallerRuns}) {
+    if (name == AdmissionPolicyName(p)) {
+      policy = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+struct AdmissionStats {
+  std::atomic_uint64_t rejected = 0;    // kReject and kCallerRuns refusals
+  std::atomic_uint64_t dropped = 0;     // elements evicted by kDropOldest
+  std::atomic_uint64_t blocked = 0;     // enqueues that had to wait
+  std::atomic_uint64_t blocked_ns = 0;  // total time spent waiting
+};
+
+#endif  // ADMISSION_POLICY_H
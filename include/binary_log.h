@@ -0,0 +1,188 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "log_format.h"
+#include "log_level.h"
+
+// Binary log file
+//
+// A file is a sequence of segments, one per logger run (a log appended to
+// by several passes holds several). A segment starts with kBinaryLogMagic,
+// then come entries, each a varint body size and the body:
+//
+//   site:   kSiteEntry, varint id, level byte, varint file size, file,
+//           varint line, varint format size, format
+//   record: kRecordEntry, zigzag varint seconds since the previous record
+//           of the segment (since the epoch for the first one), varint
+//           site id, the encoded arguments (see AppendLogArg) to the end
+//
+// A site is written before the first record of the segment that uses it,
+// site ids are local to the segment. The magic starts with a 0 byte, which
+// is never the size of an entry.
+constexpr char kBinaryLogMagic[8] = {'\0', 'L', 'F', 'B', 'L', 'O', 'G', '1'};
+
+enum BinaryLogEntry : uint8_t { kSiteEntry, kRecordEntry };
+
+// Encodes the records of one logger, it keeps the state of the segment
+// being written.
+class BinaryLogWriter {
+ public:
+  // Starts a new segment into out.
+  void Begin(std::string &out) {
+    out.assign(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+    site_ids_.clear();
+    last_time_ = 0;
+  }
+
+  // Encodes a record into out, replacing its contents but keeping its
+  // buffer.
+  void Write(time_t time, const LogSite &site, std::string_view args,
+             std::string &out) {
+    out.clear();
+    auto it = site_ids_.find(&site);
+    if (it == site_ids_.end()) {
+      it = site_ids_.emplace(&site, site_ids_.size()).first;
+      body_.clear();
+      body_.push_back(kSiteEntry);
+      PutVarint(body_, it->second);
+      body_.push_back(static_cast<char>(site.GetLevel()));
+      PutString(body_, site.GetFile());
+      PutVarint(body_, site.GetLine());
+      PutString(body_, site.GetFormat());
+      PutVarint(out, body_.size());
+      out.append(body_);
+    }
+
+    body_.clear();
+    body_.push_back(kRecordEntry);
+    PutVarint(body_, ZigZag(time - last_time_));
+    PutVarint(body_, it->second);
+    body_.append(args);
+    PutVarint(out, body_.size());
+    out.append(body_);
+    last_time_ = time;
+  }
+
+ private:
+  std::unordered_map<const LogSite *, uint64_t> site_ids_;
+  time_t last_time_ = 0;
+  std::string body_;
+
+  static void PutString(std::string &out, std::string_view s) {
+    PutVarint(out, s.size());
+    out.append(s);
+  }
+};
+
+// Walks the entries of a binary log held in memory.
+class BinaryLogReader {
+ public:
+  struct Site {
+    LogLevel level;
+    std::string_view file;
+    int line;
+    std::string_view format;
+  };
+
+  struct Entry {
+    enum { kSegment, kSite, kRecord } kind;
+    uint64_t site_id;       // kSite and kRecord
+    Site site;              // kSite
+    time_t time;            // kRecord
+    std::string_view args;  // kRecord
+  };
+
+  BinaryLogReader(const char *data, size_t size)
+      : pos_(data), end_(data + size) {}
+
+  // Returns false at the end of the log or on a malformed entry, which
+  // sets Failed().
+  bool Next(Entry &entry) {
+    if (pos_ == end_) {
+      return false;
+    }
+    if (*pos_ == '\0') {
+      if (size_t(end_ - pos_) < sizeof(kBinaryLogMagic) ||
+          std::memcmp(pos_, kBinaryLogMagic, sizeof(kBinaryLogMagic)) != 0) {
+        return Fail();
+      }
+      pos_ += sizeof(kBinaryLogMagic);
+      last_time_ = 0;
+      entry.kind = Entry::kSegment;
+      return true;
+    }
+
+    uint64_t size;
+    if (!GetVarint(pos_, end_, size) || size == 0 ||
+        uint64_t(end_ - pos_) < size) {
+      return Fail();
+    }
+    const char *body = pos_;
+    const char *body_end = pos_ + size;
+    pos_ = body_end;
+
+    uint8_t kind = static_cast<uint8_t>(*body++);
+    if (!GetVarint(body, body_end, entry.site_id)) {
+      return Fail();
+    }
+    if (kind == kRecordEntry) {
+      uint64_t delta = entry.site_id;
+      if (!GetVarint(body, body_end, entry.site_id)) {
+        return Fail();
+      }
+      last_time_ += UnZigZag(delta);
+      entry.kind = Entry::kRecord;
+      entry.time = last_time_;
+      entry.args = std::string_view(body, body_end - body);
+      return true;
+    }
+
+    uint64_t line;
+    if (kind != kSiteEntry || body == body_end ||
+        static_cast<uint8_t>(*body) > static_cast<uint8_t>(LogLevel::kError)) {
+      return Fail();
+    }
+    entry.kind = Entry::kSite;
+    entry.site.level = static_cast<LogLevel>(*body++);
+    if (!GetString(body, body_end, entry.site.file) ||
+        !GetVarint(body, body_end, line) ||
+        !GetString(body, body_end, entry.site.format)) {
+      return Fail();
+    }
+    entry.site.line = static_cast<int>(line);
+    return true;
+  }
+
+  bool Failed() const { return failed_; }
+
+ private:
+  const char *pos_;
+  const char *end_;
+  time_t last_time_ = 0;
+  bool failed_ = false;
+
+  bool Fail() {
+    failed_ = true;
+    return false;
+  }
+
+  static bool GetString(const char *&pos, const char *end,
+                        std::string_view &s) {
+    uint64_t size;
+    if (!GetVarint(pos, end, size) || uint64_t(end - pos) < size) {
+      return false;
+    }
+    s = std::string_view(pos, size);
+    pos += size;
+    return true;
+  }
+};
+
+#endif  // BINARY_LOG_H
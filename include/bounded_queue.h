@@ -0,0 +1,300 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "admission_policy.h"
+#include "cache_line.h"
+
+// Adds a capacity limit and an admission policy on top of an unbounded
+// queue. Queue must provide Enqueue(T&&) and TryDequeue(T&); blocking
+// Dequeue(T&), DequeueFor(T&, timeout), the batch TryDequeueAll(Batch&)
+// and DequeueAll(Batch&) returning the number of elements taken,
+// Emplace(args...), the two-phase ClaimWrite/Commit and ClaimRead/Release,
+// and Stop() are forwarded when the queue has them.
+//
+// kDropOldest dequeues from producer threads, so it must not be used with
+// single-consumer queues.
+//
+// The element count is kept in a separate counter, so Size() is exact only
+// when the queue is quiescent. Capacity 0 means unbounded. Queues that are
+// bounded themselves (Queue::kBounded) are constructed with the capacity
+// instead of the forwarded arguments.
+template <typename Queue>
+class BoundedQueue : public Queue {
+ public:
+  typedef typename Queue::value_type value_type;
+
+  template <typename... Args>
+  BoundedQueue(size_t capacity, AdmissionPolicy policy, Args &&...args)
+    requires(!requires { Queue::kBounded; })
+      : Queue(std::forward<Args>(args)...),
+        capacity_(capacity),
+        policy_(policy),
+        need_stop_(false),
+        size_(0),
+        waiters_(0) {}
+
+  template <typename... Args>
+  BoundedQueue(size_t capacity, AdmissionPolicy policy, Args &&...)
+    requires requires { Queue::kBounded; }
+      : Queue(capacity),
+        capacity_(capacity),
+        policy_(policy),
+        need_stop_(false),
+        size_(0),
+        waiters_(0) {}
+
+  // Returns false if the element was not admitted. With kReject and
+  // kCallerRuns `data` is left untouched so the caller can still use it.
+  bool Enqueue(value_type &&data) {
+    if (!Admit()) {
+      return false;
+    }
+    return InsertAdmitted([&] { return Queue::Enqueue(std::move(data)); });
+  }
+
+  // Like Enqueue, args are only used once the element is admitted.
+  template <typename... Args>
+  bool Emplace(Args &&...args)
+    requires requires(Queue &q) { q.Emplace(std::forward<Args>(args)...); }
+  {
+    if (!Admit()) {
+      return false;
+    }
+    if constexpr (kQueueBounded &&
+                  !std::is_nothrow_constructible_v<value_type, Args...>) {
+      // The queue would build the element again on every attempt.
+      value_type data(std::forward<Args>(args)...);
+      return InsertAdmitted([&] { return Queue::Enqueue(std::move(data)); });
+    } else {
+      return InsertAdmitted(
+          [&] { return Queue::Emplace(std::forward<Args>(args)...); });
+    }
+  }
+
+  // Admission happens at the claim: a null slot means the element was not
+  // admitted. The reservation is given back when the slot is released.
+  template <typename... Args>
+  value_type *ClaimWrite(Args &&...args)
+    requires requires(Queue &q) { q.ClaimWrite(std::forward<Args>(args)...); }
+  {
+    if (!Admit()) {
+      return nullptr;
+    }
+    value_type *slot = nullptr;
+    InsertAdmitted([&] {
+      slot = Queue::ClaimWrite(std::forward<Args>(args)...);
+      return slot != nullptr;
+    });
+    return slot;
+  }
+
+  template <typename... Args>
+  void Release(Args &&...args)
+    requires requires(Queue &q) { q.Release(std::forward<Args>(args)...); }
+  {
+    Queue::Release(std::forward<Args>(args)...);
+    Unreserve();
+  }
+
+  bool TryDequeue(value_type &data) {
+    if (!Queue::TryDequeue(data)) {
+      return false;
+    }
+    Unreserve();
+    return true;
+  }
+
+  bool Dequeue(value_type &data)
+    requires requires(Queue &q, value_type &d) { q.Dequeue(d); }
+  {
+    if (!Queue::Dequeue(data)) {
+      return false;
+    }
+    Unreserve();
+    return true;
+  }
+
+  template <typename Rep, typename Period>
+  bool DequeueFor(value_type &data,
+                  const std::chrono::duration<Rep, Period> &timeout)
+    requires requires(Queue &q, value_type &d) { q.DequeueFor(d, timeout); }
+  {
+    if (!Queue::DequeueFor(data, timeout)) {
+      return false;
+    }
+    Unreserve();
+    return true;
+  }
+
+  template <typename Batch>
+  size_t TryDequeueAll(Batch &data)
+    requires requires(Queue &q, Batch &b) { q.TryDequeueAll(b); }
+  {
+    size_t count = Queue::TryDequeueAll(data);
+    if (count > 0) {
+      Unreserve(count);
+    }
+    return count;
+  }
+
+  template <typename Batch>
+  size_t DequeueAll(Batch &data)
+    requires requires(Queue &q, Batch &b) { q.DequeueAll(b); }
+  {
+    size_t count = Queue::DequeueAll(data);
+    if (count > 0) {
+      Unreserve(count);
+    }
+    return count;
+  }
+
+  void Stop() {
+    {
+      std::unique_lock<std::mutex> lock(not_full_lock_);
+      need_stop_ = true;
+    }
+    not_full_condition_.notify_all();
+
+    if constexpr (requires(Queue &q) { q.Stop(); }) {
+      Queue::Stop();
+    }
+  }
+
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+  size_t GetCapacity() const { return capacity_; }
+  AdmissionPolicy GetPolicy() const { return policy_; }
+  const AdmissionStats &GetStats() const { return stats_; }
+
+ private:
+  static constexpr bool kQueueBounded = requires { Queue::kBounded; };
+
+  // Read-mostly state first, then one line per frequently written field.
+  alignas(kCacheLineSize) const size_t capacity_;
+  const AdmissionPolicy policy_;
+  std::atomic_bool need_stop_;
+
+  alignas(kCacheLineSize) std::atomic_size_t size_;
+  alignas(kCacheLineSize) std::atomic_size_t waiters_;
+  std::mutex not_full_lock_;
+  std::condition_variable not_full_condition_;
+
+  alignas(kCacheLineSize) AdmissionStats stats_;
+
+  // Reserves a place for a new element as the policy says.
+  bool Admit() {
+    if (TryReserve()) {
+      return true;
+    }
+    switch (policy_) {
+      case AdmissionPolicy::kBlock:
+        return WaitReserve();
+      case AdmissionPolicy::kDropOldest:
+        return DropOldest();
+      case AdmissionPolicy::kReject:
+      case AdmissionPolicy::kCallerRuns:
+        break;
+    }
+    stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Puts an admitted element into the queue with insert(), which returns
+  // false if the queue refused it. A queue bounded by itself may still be
+  // full for a moment after admission: a consumer between ClaimRead and
+  // Release holds the oldest slot while another one has already freed our
+  // place. The reservation stands, so the element waits for the slot
+  // instead of being lost, unless the queue is stopped.
+  template <typename Insert>
+  bool InsertAdmitted(Insert insert) {
+    while (!insert()) {
+      if (!kQueueBounded || need_stop_) {
+        Unreserve();
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  // Counts the element only while there is room, so a failed attempt never
+  // makes the queue look full to another producer.
+  bool TryReserve() {
+    if (capacity_ == 0) {
+      size_.fetch_add(1);
+      return true;
+    }
+    size_t size = size_.load();
+    while (size < capacity_) {
+      if (size_.compare_exchange_weak(size, size + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Unreserve(size_t count = 1) {
+    size_.fetch_sub(count);
+    // Pairs with the waiters_ increment in WaitReserve: either the producer
+    // sees the new size or we see the producer and wake it under the lock.
+    if (waiters_.load() > 0) {
+      std::unique_lock<std::mutex> lock(not_full_lock_);
+      if (count == 1) {
+        not_full_condition_.notify_one();
+      } else {
+        not_full_condition_.notify_all();
+      }
+    }
+  }
+
+  bool WaitReserve() {
+    auto ts = std::chrono::steady_clock::now();
+    bool reserved = false;
+    {
+      std::unique_lock<std::mutex> lock(not_full_lock_);
+      waiters_.fetch_add(1);
+      not_full_condition_.wait(lock, [this, &reserved] {
+        reserved = !need_stop_ && TryReserve();
+        return reserved || need_stop_;
+      });
+      waiters_.fetch_sub(1);
+    }
+    auto te = std::chrono::steady_clock::now();
+
+    stats_.blocked.fetch_add(1, std::memory_order_relaxed);
+    stats_.blocked_ns.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(te - ts).count(),
+        std::memory_order_relaxed);
+    return reserved;
+  }
+
+  // Evicts elements until our reservation fits. The evicted element's place
+  // is taken over by the new one, so the counter is left as is.
+  bool DropOldest() {
+    value_type oldest;
+    while (true) {
+      if (Queue::TryDequeue(oldest)) {
+        stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      if (TryReserve()) {
+        return true;
+      }
+      if (need_stop_) {
+        return false;
+      }
+      // Nothing to evict yet: the admitted elements are still being
+      // inserted or the oldest slot is still held by a consumer.
+      std::this_thread::yield();
+    }
+  }
+};
+
+#endif  // BOUNDED_QUEUE_H
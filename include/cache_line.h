@@ -0,0 +1,28 @@
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <cstddef>
+#include <new>
+
+// Minimal distance between two objects written by different threads that
+// avoids false sharing. Hot atomics are aligned to it, so every one of them
+// owns a cache line.
+#ifdef __cpp_lib_hardware_interference_size
+constexpr size_t kCacheLineSize = std::hardware_destructive_interference_size;
+#else
+constexpr size_t kCacheLineSize = 64;
+#endif
+
+// Alignment of the old packed layout. The lock-free types with hot shared
+// state take their alignment as a template parameter defaulting to
+// kCacheLineSize; false-sharing-bench instantiates them with kPackedAlign
+// to measure what the padding buys.
+constexpr size_t kPackedAlign = alignof(std::max_align_t);
+
+// Pads T to a whole number of cache lines, e.g. for per-thread array slots.
+template <typename T, size_t kAlign = kCacheLineSize>
+struct alignas(kAlign) CacheLinePadded {
+  T value;
+};
+
+#endif  // CACHE_LINE_H
@@ -1,8 +1,20 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
+
+#include "admission_policy.h"
+#include "log_format.h"
+#include "log_level.h"
+
+enum class LoadMode {
+  kClosed,    // each generator thread sleeps 0-7 ms between tasks
+  kConstant,  // open loop, fixed interval between arrivals
+  kPoisson    // open loop, exponentially distributed interarrival times
+};
 
 class Config {
  public:
@@ -12,11 +24,44 @@ class Config {
   void Parse(std::istream *is); // throw: std::invalid_argument
 
   size_t GetThreadsNumber() const { return threads_number_; }
+  // Elastic pool bounds, both default to threads_number (fixed size pool).
+  size_t GetMinThreadsNumber() const {
+    return min_threads_number_ ? min_threads_number_ : threads_number_;
+  }
+  size_t GetMaxThreadsNumber() const {
+    return std::max(GetMinThreadsNumber(), max_threads_number_
+                                               ? max_threads_number_
+                                               : threads_number_);
+  }
+  size_t GetThreadIdleTimeoutMs() const { return thread_idle_timeout_ms_; }
   size_t GetTaskGeneratorThreadNumber() const { return task_gen_threads_number_; }
+  size_t GetTaskGeneratorBatchSize() const { return task_gen_batch_size_; }
   size_t GetTasksBufferSize() const { return tasks_buffer_size_; }
   size_t GetLogBufferSize() const { return log_buffer_size_; }
+  AdmissionPolicy GetTasksAdmissionPolicy() const {
+    return tasks_admission_policy_;
+  }
+  AdmissionPolicy GetLogAdmissionPolicy() const {
+    return log_admission_policy_;
+  }
   size_t GetTasksNumber() const { return tasks_number_; }
   const std::string &GetLogFilePath() const { return log_file_path_; }
+  const std::vector<std::string> &GetLogMirrorPaths() const {
+    return log_mirror_paths_;
+  }
+  LogFormat GetLogFormat() const { return log_format_; }
+  const std::string &GetLogPattern() const { return log_pattern_; }
+  LogLevel GetLogLevel() const { return log_level_; }
+  // Patterns of the log sites turned off, see LogSites.
+  const std::vector<std::string> &GetLogDisabledSites() const {
+    return log_disabled_sites_;
+  }
+  // Empty if task results are not saved.
+  const std::string &GetResultsFilePath() const { return results_file_path_; }
+  bool IsAsymmetricHazardFence() const { return asymmetric_hazard_fence_; }
+  LoadMode GetLoadMode() const { return load_mode_; }
+  double GetTasksRate() const { return tasks_rate_; }
+  const std::vector<double> &GetRateSweep() const { return rate_sweep_; }
 
  private:
   Config(const Config &) = delete;
@@ -25,11 +70,27 @@ class Config {
   Config& operator=(Config &&) = delete;
 
   size_t threads_number_ = 16;
+  size_t min_threads_number_ = 0;
+  size_t max_threads_number_ = 0;
+  size_t thread_idle_timeout_ms_ = 1000;
   size_t task_gen_threads_number_ = 8;
+  size_t task_gen_batch_size_ = 1;
   size_t tasks_buffer_size_ = 128;
   size_t log_buffer_size_ = 256;
+  AdmissionPolicy tasks_admission_policy_ = AdmissionPolicy::kBlock;
+  AdmissionPolicy log_admission_policy_ = AdmissionPolicy::kBlock;
   size_t tasks_number_ = 1000;
   std::string log_file_path_;
+  std::vector<std::string> log_mirror_paths_;
+  LogFormat log_format_ = LogFormat::kText;
+  std::string log_pattern_ = kDefaultLogPattern;
+  LogLevel log_level_ = LogLevel::kInfo;
+  std::vector<std::string> log_disabled_sites_;
+  std::string results_file_path_;
+  bool asymmetric_hazard_fence_ = false;
+  LoadMode load_mode_ = LoadMode::kClosed;
+  double tasks_rate_ = 1000.0;
+  std::vector<double> rate_sweep_;
 
   class ConfigImpl;
   std::unique_ptr<ConfigImpl> impl_;
@@ -0,0 +1,106 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+// Log-linear latency histogram (HdrHistogram-like, ~6% relative error).
+// Record is wait-free and may be called from any number of threads.
+class LatencyHistogram {
+ public:
+  LatencyHistogram() { Reset(); }
+  LatencyHistogram(const LatencyHistogram &) = delete;
+
+  void Record(std::chrono::nanoseconds latency) {
+    uint64_t v = latency.count() < 0 ? 0 : latency.count();
+    buckets_[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (v > max &&
+           !max_.compare_exchange_weak(max, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  void Reset() {
+    for (auto &bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  std::chrono::nanoseconds Max() const {
+    return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+  }
+
+  std::chrono::nanoseconds Mean() const {
+    uint64_t count = Count();
+    if (count == 0) {
+      return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(sum_.load(std::memory_order_relaxed) /
+                                    count);
+  }
+
+  // q in [0, 1]. Returns the upper bound of the bucket holding the quantile.
+  std::chrono::nanoseconds Percentile(double q) const {
+    uint64_t count = Count();
+    if (count == 0) {
+      return std::chrono::nanoseconds(0);
+    }
+
+    uint64_t rank = static_cast<uint64_t>(q * count);
+    rank = std::clamp<uint64_t>(rank, 1, count);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketsNum; ++i) {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank) {
+        return std::chrono::nanoseconds(
+            std::min<uint64_t>(BucketUpperBound(i), max_.load()));
+      }
+    }
+    return Max();
+  }
+
+ private:
+  static constexpr int kSubBits = 5;
+  static constexpr uint64_t kSubCount = 1ull << kSubBits;
+  static constexpr uint64_t kHalfSubCount = kSubCount / 2;
+  static constexpr size_t kBucketsNum =
+      kSubCount + (64 - kSubBits) * kHalfSubCount;
+
+  static size_t BucketIndex(uint64_t v) {
+    if (v < kSubCount) {
+      return v;
+    }
+    int shift = std::bit_width(v) - kSubBits;
+    uint64_t sub = (v >> shift) & (kHalfSubCount - 1);
+    return kSubCount + (shift - 1) * kHalfSubCount + sub;
+  }
+
+  static uint64_t BucketUpperBound(size_t idx) {
+    if (idx < kSubCount) {
+      return idx;
+    }
+    int shift = (idx - kSubCount) / kHalfSubCount + 1;
+    uint64_t sub = (idx - kSubCount) % kHalfSubCount;
+    return ((kHalfSubCount + sub + 1) << shift) - 1;
+  }
+
+  std::array<std::atomic_uint64_t, kBucketsNum> buckets_;
+  std::atomic_uint64_t count_;
+  std::atomic_uint64_t sum_;
+  std::atomic_uint64_t max_;
+};
+
+#endif  // LATENCY_HISTOGRAM_H
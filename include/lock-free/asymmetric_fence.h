@@ -0,0 +1,77 @@
+#ifndef LOCK_FREE_ASYMMETRIC_FENCE_H
+#define LOCK_FREE_ASYMMETRIC_FENCE_H
+
+#include <atomic>
+
+#ifdef __linux__
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace lock_free {
+
+enum class FenceMode {
+  kSymmetric,  // both sides issue a full seq_cst fence
+  kAsymmetric  // readers: compiler fence only, scanners: membarrier()
+};
+
+// Store-load fence split between a frequent side (hazard pointer readers)
+// and a rare side (scanning threads). In asymmetric mode the rare side runs
+// membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED), which executes a full fence
+// on every CPU running a thread of this process, so the frequent side only
+// has to keep the compiler from reordering.
+//
+// The mode must be chosen before any thread uses the fences.
+class AsymmetricFence {
+ public:
+  // Returns the mode in effect: kAsymmetric falls back to kSymmetric when
+  // the kernel does not support private expedited membarrier.
+  static FenceMode SetMode(FenceMode mode) {
+    if (mode == FenceMode::kAsymmetric && !RegisterMembarrier()) {
+      mode = FenceMode::kSymmetric;
+    }
+    mode_.store(mode, std::memory_order_relaxed);
+    return mode;
+  }
+
+  static FenceMode GetMode() { return mode_.load(std::memory_order_relaxed); }
+
+  static void Light() {
+    if (GetMode() == FenceMode::kAsymmetric) {
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  static void Heavy() {
+#ifdef __linux__
+    if (GetMode() == FenceMode::kAsymmetric &&
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0) {
+      return;
+    }
+#endif  // __linux__
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+ private:
+  inline static std::atomic<FenceMode> mode_ = FenceMode::kSymmetric;
+
+  static bool RegisterMembarrier() {
+#ifdef __linux__
+    long cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0);
+    if (cmds < 0 || !(cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) {
+      return false;
+    }
+    return syscall(__NR_membarrier,
+                   MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#else   // __linux__
+    return false;
+#endif  // __linux__
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_ASYMMETRIC_FENCE_H
@@ -0,0 +1,256 @@
+#ifndef LOCK_FREE_BOUNDED_RING_H
+#define LOCK_FREE_BOUNDED_RING_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+
+namespace lock_free {
+
+enum class Producers { kSingle, kMulti };
+enum class Consumers { kSingle, kMulti };
+
+// Slots of a BoundedRing: inline for a static capacity, on the heap when
+// the capacity is given at run time (kCapacity == 0). Either way the slot
+// count is a power of two, positions are masked rather than divided.
+template <typename Cell, size_t kCapacity>
+struct RingStorage {
+  static_assert(std::has_single_bit(kCapacity),
+                "kCapacity must be a power of two");
+
+  explicit RingStorage(size_t) {}
+  static constexpr size_t Capacity() { return kCapacity; }
+
+  Cell cells[kCapacity];
+};
+
+template <typename Cell>
+struct RingStorage<Cell, 0> {
+  explicit RingStorage(size_t capacity)
+      : cells(new Cell[std::bit_ceil(capacity)]),
+        capacity_(std::bit_ceil(capacity)) {}
+  size_t Capacity() const { return capacity_; }
+
+  std::unique_ptr<Cell[]> cells;
+  size_t capacity_;
+};
+
+// Bounded ring specialized at compile time for the number of producers and
+// consumers:
+//  - SPSC: Lamport ring, each side owns its index and keeps a cached copy
+//    of the other one, refreshed only when the ring looks full or empty.
+//    No read-modify-write at all.
+//  - MPSC, SPMC, MPMC: per-slot sequence numbers (Vyukov). A multi side
+//    claims a position with a CAS, a single side with a plain store.
+// Enqueue fails when the ring is full, TryDequeue when it is empty.
+//
+// kBounded tells BoundedQueue to pass its capacity to the constructor. A
+// static capacity must be at least the requested one, a run-time one is
+// rounded up to a power of two; BoundedQueue still enforces its own limit.
+template <typename T, Producers kProducers, Consumers kConsumers,
+          size_t kCapacity = 0>
+class BoundedRing {
+ public:
+  typedef T value_type;
+  static constexpr bool kBounded = true;
+  // Largest capacity the ring can be built with, 0 if there is no limit.
+  static constexpr size_t kMaxCapacity = kCapacity;
+
+  explicit BoundedRing(size_t capacity = kCapacity) : storage_(capacity) {
+    if (capacity == 0) {
+      throw std::invalid_argument("BoundedRing capacity must be positive");
+    }
+    if (kCapacity != 0 && capacity > kCapacity) {
+      throw std::invalid_argument("BoundedRing capacity must not exceed " +
+                                  std::to_string(kCapacity));
+    }
+    if constexpr (!kSpsc) {
+      for (size_t i = 0; i < Capacity(); ++i) {
+        storage_.cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  BoundedRing(const BoundedRing &) = delete;
+
+  // No per-thread state, these keep the lock-free queue interface.
+  void RegisterThread() {}
+  void UnregisterThread() {}
+
+  size_t Capacity() const { return storage_.Capacity(); }
+
+  bool Enqueue(T &&data) {
+    size_t pos;
+    T *slot = ClaimWrite(pos);
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = std::move(data);
+    Commit(pos);
+    return true;
+  }
+
+  // Rebuilds the slot's element from args. If that may throw, the element
+  // is built first, so that a claimed slot is never left unpublished.
+  template <typename... Args>
+  bool Emplace(Args &&...args) {
+    if constexpr (!std::is_nothrow_constructible_v<T, Args...>) {
+      return Enqueue(T(std::forward<Args>(args)...));
+    } else {
+      size_t pos;
+      T *slot = ClaimWrite(pos);
+      if (slot == nullptr) {
+        return false;
+      }
+      std::destroy_at(slot);
+      std::construct_at(slot, std::forward<Args>(args)...);
+      Commit(pos);
+      return true;
+    }
+  }
+
+  bool TryDequeue(T &data) {
+    size_t pos;
+    T *slot = ClaimRead(pos);
+    if (slot == nullptr) {
+      return false;
+    }
+    data = std::move(*slot);
+    Release(pos);
+    return true;
+  }
+
+  // Two-phase access to the slots, which always hold a live T. ClaimWrite
+  // returns the next free slot (null if the ring is full) for the producer
+  // to fill in place, reusing whatever the old element owns, and Commit
+  // publishes it. ClaimRead returns the oldest element (null if empty) for
+  // the consumer to use where it is, Release hands the slot back. pos ties
+  // the two calls together; a claimed slot holds up the ring on its side
+  // until it is committed or released.
+  T *ClaimWrite(size_t &pos) {
+    if constexpr (kSpsc) {
+      pos = tail_.load(std::memory_order_relaxed);
+      if (pos - cached_head_ == Capacity()) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (pos - cached_head_ == Capacity()) {
+          return nullptr;
+        }
+      }
+      return &storage_.cells[pos & (Capacity() - 1)].data;
+    } else {
+      Cell *cell = Claim<kProducers == Producers::kMulti>(tail_, 0, pos);
+      return cell != nullptr ? &cell->data : nullptr;
+    }
+  }
+
+  void Commit(size_t pos) {
+    if constexpr (kSpsc) {
+      tail_.store(pos + 1, std::memory_order_release);
+    } else {
+      storage_.cells[pos & (Capacity() - 1)].seq.store(
+          pos + 1, std::memory_order_release);
+    }
+  }
+
+  T *ClaimRead(size_t &pos) {
+    if constexpr (kSpsc) {
+      pos = head_.load(std::memory_order_relaxed);
+      if (pos == cached_tail_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (pos == cached_tail_) {
+          return nullptr;
+        }
+      }
+      return &storage_.cells[pos & (Capacity() - 1)].data;
+    } else {
+      Cell *cell = Claim<kConsumers == Consumers::kMulti>(head_, 1, pos);
+      return cell != nullptr ? &cell->data : nullptr;
+    }
+  }
+
+  void Release(size_t pos) {
+    if constexpr (kSpsc) {
+      head_.store(pos + 1, std::memory_order_release);
+    } else {
+      storage_.cells[pos & (Capacity() - 1)].seq.store(
+          pos + Capacity(), std::memory_order_release);
+    }
+  }
+
+  // Appends all available elements to data, returns their number.
+  size_t TryDequeueAll(std::vector<T> &data) {
+    size_t count = 0;
+    T value;
+    while (TryDequeue(value)) {
+      data.push_back(std::move(value));
+      ++count;
+    }
+    return count;
+  }
+
+ private:
+  static constexpr bool kSpsc =
+      kProducers == Producers::kSingle && kConsumers == Consumers::kSingle;
+
+  struct PlainCell {
+    T data;
+  };
+  struct SeqCell {
+    std::atomic_size_t seq;
+    T data;
+  };
+  typedef std::conditional_t<kSpsc, PlainCell, SeqCell> Cell;
+
+  // Consumer side: its index and its copy of the producer index.
+  alignas(kCacheLineSize) std::atomic_size_t head_ = 0;
+  size_t cached_tail_ = 0;
+
+  // Producer side.
+  alignas(kCacheLineSize) std::atomic_size_t tail_ = 0;
+  size_t cached_head_ = 0;
+
+  alignas(kCacheLineSize) RingStorage<Cell, kCapacity> storage_;
+
+  // Claims the slot at `index` for the side owning it. The slot is ready
+  // when its sequence is the position plus `lag` (0 for producers, 1 for
+  // consumers); a smaller one means full/empty.
+  template <bool kShared>
+  Cell *Claim(std::atomic_size_t &index, size_t lag, size_t &pos) {
+    pos = index.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = storage_.cells[pos & (Capacity() - 1)];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) -
+                      static_cast<intptr_t>(pos + lag);
+      if (diff < 0) {
+        return nullptr;
+      }
+      if (diff == 0) {
+        if constexpr (kShared) {
+          if (index.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+            return &cell;
+          }
+          continue;
+        } else {
+          index.store(pos + 1, std::memory_order_relaxed);
+          return &cell;
+        }
+      }
+      // Another thread of our side has moved on.
+      pos = index.load(std::memory_order_relaxed);
+    }
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_BOUNDED_RING_H
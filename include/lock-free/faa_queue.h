@@ -0,0 +1,284 @@
+#ifndef LOCK_FREE_FAA_QUEUE_H
+#define LOCK_FREE_FAA_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "cache_line.h"
+#include "lock-free/hazard_pointers.h"
+
+namespace lock_free {
+
+// Unbounded MPMC queue of linked array segments (FAAArrayQueue, Ramalhete
+// and Correia). Producers and consumers claim a slot with one fetch_add on
+// the segment enq/deq index instead of retrying a CAS on a shared pointer;
+// a CAS is only needed once per segment to link or unlink it. A consumer
+// that overtakes a slow producer marks the slot as taken and both retry
+// with new indices. Drained segments are retired through HazardPointers,
+// which hands them to a free list once no thread can reach them; new
+// segments are taken from it, so a steady stream of elements does not
+// allocate.
+template <typename T, size_t kSegmentSize = 1024>
+class FaaArrayQueue {
+ public:
+  typedef T value_type;
+
+  FaaArrayQueue(size_t tnum)
+      : free_segments_(2 * tnum + 16),
+        hp_(tnum, SegmentRecycler{&free_segments_}) {
+    Segment* segment = free_segments_.Get();
+    head_.store(segment, std::memory_order_relaxed);
+    tail_.store(segment, std::memory_order_relaxed);
+  }
+
+  FaaArrayQueue(const FaaArrayQueue&) = delete;
+
+  ~FaaArrayQueue() {
+    Segment* segment = head_.load(std::memory_order_relaxed);
+    while (segment != nullptr) {
+      Segment* next = segment->next.load(std::memory_order_relaxed);
+      delete segment;
+      segment = next;
+    }
+  }
+
+  void RegisterThread() { hp_.AddThread(); }
+  void UnregisterThread() { hp_.RemoveThread(); }
+
+  // A slot abandoned by a consumer hands the element back for a retry, so
+  // it is built before a slot is claimed.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Enqueue(T(std::forward<Args>(args)...));
+  }
+
+  bool Enqueue(T&& data) {
+    while (true) {
+      Segment* tail = Protect(tail_);
+      size_t idx = tail->enq_idx.fetch_add(1);
+      if (idx >= kSegmentSize) {
+        if (tail != tail_.load()) {
+          continue;
+        }
+        Segment* next = tail->next.load();
+        if (next != nullptr) {
+          tail_.compare_exchange_strong(tail, next);
+          continue;
+        }
+
+        // The segment is full: append a new one with our element in slot 0.
+        Segment* segment = free_segments_.Get();
+        segment->enq_idx.store(1, std::memory_order_relaxed);
+        segment->slots[0].Put(std::move(data));
+        segment->slots[0].state.store(kFull, std::memory_order_relaxed);
+        if (tail->next.compare_exchange_strong(next, segment)) {
+          tail_.compare_exchange_strong(tail, segment);
+          hp_.ReleaseHazardPointer(0);
+          return true;
+        }
+        data = segment->slots[0].Take();
+        segment->slots[0].state.store(kEmpty, std::memory_order_relaxed);
+        free_segments_.Put(segment);
+        continue;
+      }
+
+      Slot& slot = tail->slots[idx];
+      slot.Put(std::move(data));
+      uint8_t state = kEmpty;
+      if (slot.state.compare_exchange_strong(state, kFull,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+        hp_.ReleaseHazardPointer(0);
+        return true;
+      }
+      // A consumer gave up on this slot before we filled it, retry.
+      data = slot.Take();
+    }
+  }
+
+  // Segments allocated so far, the others were recycled.
+  uint64_t GetSegmentsAllocated() const {
+    return free_segments_.GetAllocated();
+  }
+
+  bool TryDequeue(T& data) {
+    while (true) {
+      Segment* head = Protect(head_);
+      if (head->deq_idx.load() >= head->enq_idx.load() &&
+          head->next.load() == nullptr) {
+        hp_.ReleaseHazardPointer(0);
+        return false;
+      }
+
+      size_t idx = head->deq_idx.fetch_add(1);
+      if (idx >= kSegmentSize) {
+        Segment* next = head->next.load();
+        if (next == nullptr) {
+          hp_.ReleaseHazardPointer(0);
+          return false;
+        }
+        // Never let head pass tail, otherwise a retired segment could
+        // still be reachable through tail_.
+        Segment* tail = head;
+        tail_.compare_exchange_strong(tail, next);
+        if (head_.compare_exchange_strong(head, next)) {
+          hp_.ReleaseHazardPointer(0);
+          hp_.Retire(head);
+        }
+        continue;
+      }
+
+      Slot& slot = head->slots[idx];
+      // The producer owning this index may still be writing, give it a
+      // moment before taking the slot away from it.
+      for (size_t i = 0;
+           i < kWaitSpins && slot.state.load(std::memory_order_acquire) ==
+                                 kEmpty;
+           ++i) {
+      }
+      if (slot.state.exchange(kTaken, std::memory_order_acq_rel) == kFull) {
+        data = slot.Take();
+        hp_.ReleaseHazardPointer(0);
+        return true;
+      }
+    }
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0;
+  static constexpr uint8_t kFull = 1;
+  static constexpr uint8_t kTaken = 2;
+  static constexpr size_t kWaitSpins = 64;
+
+  struct Slot {
+    std::atomic<uint8_t> state = kEmpty;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    void Put(T&& data) { new (storage) T(std::move(data)); }
+
+    T Take() {
+      T* ptr = std::launder(reinterpret_cast<T*>(storage));
+      T data(std::move(*ptr));
+      ptr->~T();
+      return data;
+    }
+  };
+
+  struct Segment {
+    alignas(kCacheLineSize) std::atomic_size_t deq_idx = 0;
+    alignas(kCacheLineSize) std::atomic_size_t enq_idx = 0;
+    alignas(kCacheLineSize) std::atomic<Segment*> next = nullptr;
+    Slot slots[kSegmentSize];
+
+    ~Segment() { Clear(); }
+
+    // Destroys the elements left, a drained segment has none.
+    void Clear() {
+      for (Slot& slot : slots) {
+        if (slot.state.load(std::memory_order_relaxed) == kFull) {
+          slot.Take();
+        }
+      }
+    }
+
+    void Reset() {
+      Clear();
+      for (Slot& slot : slots) {
+        slot.state.store(kEmpty, std::memory_order_relaxed);
+      }
+      deq_idx.store(0, std::memory_order_relaxed);
+      enq_idx.store(0, std::memory_order_relaxed);
+      next.store(nullptr, std::memory_order_relaxed);
+    }
+  };
+
+  // Used once per kSegmentSize elements, so a lock is cheap enough, and a
+  // segment comes back only when HazardPointers has proven it unreachable,
+  // so reuse has no ABA problem. The release of the lock orders the reset
+  // of a segment before its publication by the next owner.
+  //
+  // It keeps up to max_free segments, sized to hold what one scan of the
+  // hazard pointers frees with the expected number of threads (2 * H + 16);
+  // the ones beyond are deleted.
+  class SegmentPool {
+   public:
+    explicit SegmentPool(size_t max_free) : max_free_(max_free) {
+      free_.reserve(max_free_);
+    }
+
+    ~SegmentPool() {
+      for (Segment* segment : free_) {
+        delete segment;
+      }
+    }
+
+    Segment* Get() {
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (!free_.empty()) {
+          Segment* segment = free_.back();
+          free_.pop_back();
+          return segment;
+        }
+      }
+      allocated_.fetch_add(1, std::memory_order_relaxed);
+      return new Segment;
+    }
+
+    void Put(Segment* segment) {
+      segment->Reset();
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (free_.size() < max_free_) {
+          free_.push_back(segment);
+          return;
+        }
+      }
+      delete segment;
+    }
+
+    uint64_t GetAllocated() const {
+      return allocated_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    const size_t max_free_;
+    std::mutex lock_;
+    std::vector<Segment*> free_;
+    std::atomic_uint64_t allocated_ = 0;
+  };
+
+  struct SegmentRecycler {
+    SegmentPool* pool;
+    void operator()(Segment* segment) const { pool->Put(segment); }
+  };
+
+  Segment* Protect(std::atomic<Segment*>& ptr) {
+    Segment* segment = ptr.load();
+    while (true) {
+      hp_.AcquireHazardPointer(0, segment);
+      Segment* current = ptr.load();
+      if (current == segment) {
+        return segment;
+      }
+      segment = current;
+    }
+  }
+
+  alignas(kCacheLineSize) std::atomic<Segment*> head_;
+  alignas(kCacheLineSize) std::atomic<Segment*> tail_;
+
+  // Declared before hp_, which returns its last segments on destruction.
+  alignas(kCacheLineSize) SegmentPool free_segments_;
+  alignas(kCacheLineSize)
+      HazardPointers<Segment, 1, kCacheLineSize, SegmentRecycler> hp_;
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_FAA_QUEUE_H
@@ -0,0 +1,402 @@
+#ifndef LOCK_FREE_HASH_MAP_H
+#define LOCK_FREE_HASH_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "cache_line.h"
+#include "lock-free/hazard_pointers.h"
+
+namespace lock_free {
+
+// Open-addressing hash map with linear probing for integral keys.
+//
+// A slot holds a key, set once by CAS, and a pointer to a heap node with
+// the value. Assign swaps the node pointer by CAS and erase swaps in an
+// erased mark, leaving the key as a tombstone; replaced nodes are retired
+// through hazard pointers, so Find can copy a value out of a node while it
+// is being replaced.
+//
+// Resizing is cooperative and incremental. When a table gets 3/4 full a
+// larger one (or one of the same size if it is mostly tombstones) is hung
+// off it, and every writer that meets the migration claims chunks of
+// kChunk slots and moves them: each value pointer is frozen with a tag bit,
+// which makes later CASes on it fail, and the node is linked into the new
+// table. Once no chunk is left to claim, a writer copies again the chunks
+// that are claimed but not finished rather than wait for their owners, and
+// makes the new table the root by CAS, retiring the old one: a stalled
+// thread never holds the others up. Copies of a slot are idempotent: the
+// target is only written by CAS from a never used slot, and a value that
+// was ever set there (an erase leaves the erased mark) makes a late copy
+// fail. Readers never wait, a frozen value is still current until the root
+// changes.
+//
+// ForEach is weakly consistent: it sees each key at most once and may miss
+// or include changes made during the iteration.
+//
+// The maximum key value is reserved for empty slots.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class HashMap {
+ public:
+  static_assert(std::is_integral_v<K>, "keys must be integral");
+
+  typedef K key_type;
+  typedef V mapped_type;
+
+  // tnum is the expected number of threads, capacity is rounded up to a
+  // power of two.
+  explicit HashMap(size_t tnum, size_t capacity = kMinCapacity)
+      : node_hp_(tnum),
+        table_hp_(tnum),
+        root_(new Table(std::bit_ceil(std::max(capacity, kMinCapacity)))),
+        size_(0) {}
+
+  HashMap(const HashMap &) = delete;
+
+  // No thread may use the map any more.
+  ~HashMap() {
+    Table *table = root_.load();
+    for (size_t i = 0; i < table->capacity; ++i) {
+      delete Strip(table->slots[i].value.load());
+    }
+    delete table;
+  }
+
+  void RegisterThread() {
+    node_hp_.AddThread();
+    table_hp_.AddThread();
+  }
+
+  void UnregisterThread() {
+    node_hp_.RemoveThread();
+    table_hp_.RemoveThread();
+  }
+
+  bool Find(K key, V &value) {
+    assert(key != kEmptyKey);
+    while (true) {
+      Table *table = ProtectTable();
+      Slot *slot = FindSlot(table, key);
+      uintptr_t raw;
+      Node *node = slot != nullptr ? ProtectNode(slot, raw) : nullptr;
+      // Writes to the next table only start once it is the root.
+      if (root_.load() != table) {
+        continue;
+      }
+      if (node != nullptr) {
+        value = node->value;
+        node_hp_.ReleaseHazardPointer(0);
+      }
+      table_hp_.ReleaseHazardPointer(0);
+      return node != nullptr;
+    }
+  }
+
+  // Returns true if the key was not in the map.
+  bool InsertOrAssign(K key, V value) {
+    assert(key != kEmptyKey);
+    Node *node = new Node{std::move(value)};
+    Node *old = Update(key, reinterpret_cast<uintptr_t>(node), true);
+    if (old != nullptr) {
+      node_hp_.Retire(old);
+      return false;
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Returns false if the key was not in the map.
+  bool Erase(K key) {
+    assert(key != kEmptyKey);
+    Node *old = Update(key, kErased, false);
+    if (old == nullptr) {
+      return false;
+    }
+    node_hp_.Retire(old);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Calls f(key, value) for the entries of the table that is the root
+  // when the iteration starts.
+  template <typename F>
+  void ForEach(F f) {
+    Table *table = ProtectTable(1);
+    for (size_t i = 0; i < table->capacity; ++i) {
+      Slot &slot = table->slots[i];
+      K key = slot.key.load(std::memory_order_acquire);
+      if (key == kEmptyKey) {
+        continue;
+      }
+      uintptr_t raw;
+      Node *node = ProtectNode(&slot, raw);
+      if (node == nullptr) {
+        continue;
+      }
+      if ((raw & kFrozen) != 0 && root_.load() != table) {
+        // The entry has moved on and may be replaced there, so the frozen
+        // node is not protected by our hazard pointer.
+        V value;
+        if (Find(key, value)) {
+          f(key, static_cast<const V &>(value));
+        }
+      } else {
+        f(key, static_cast<const V &>(node->value));
+      }
+      node_hp_.ReleaseHazardPointer(0);
+    }
+    table_hp_.ReleaseHazardPointer(1);
+  }
+
+  // Approximate while the map is modified.
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+  size_t Capacity() {
+    Table *table = ProtectTable();
+    size_t capacity = table->capacity;
+    table_hp_.ReleaseHazardPointer(0);
+    return capacity;
+  }
+
+ private:
+  static constexpr K kEmptyKey = std::numeric_limits<K>::max();
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kChunk = 256;
+  static constexpr uintptr_t kFrozen = 1;
+  // Slot value of an erased key, a slot never used holds 0.
+  static constexpr uintptr_t kErased = 2;
+
+  struct Node {
+    V value;
+  };
+
+  struct Slot {
+    std::atomic<K> key = kEmptyKey;
+    // Node pointer or kErased, kFrozen is set once the slot is being
+    // migrated.
+    std::atomic<uintptr_t> value = 0;
+  };
+
+  struct Table {
+    explicit Table(size_t cap)
+        : capacity(cap),
+          chunks((cap + kChunk - 1) / kChunk),
+          slots(new Slot[cap]),
+          copied(new std::atomic_bool[chunks]()) {}
+
+    const size_t capacity;
+    const size_t chunks;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<Table *> next = nullptr;
+    alignas(kCacheLineSize) std::atomic_size_t used = 0;
+    alignas(kCacheLineSize) std::atomic_size_t copy_cursor = 0;
+    std::unique_ptr<std::atomic_bool[]> copied;  // per chunk
+  };
+
+  HazardPointers<Node, 1> node_hp_;
+  // Slot 1 keeps the table of a ForEach while it calls Find, slot 2 the
+  // table a migration copies into.
+  HazardPointers<Table, 3> table_hp_;
+  alignas(kCacheLineSize) std::atomic<Table *> root_;
+  alignas(kCacheLineSize) std::atomic_size_t size_;
+
+  // Null for an empty or erased slot.
+  static Node *Strip(uintptr_t value) {
+    return reinterpret_cast<Node *>(value & ~(kFrozen | kErased));
+  }
+
+  static size_t Index(K key) {
+    // Murmur3 finalizer, std::hash is the identity for integers.
+    uint64_t h = Hash()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  Table *ProtectTable(size_t ind = 0) {
+    Table *table = root_.load();
+    while (true) {
+      table_hp_.AcquireHazardPointer(ind, table);
+      Table *current = root_.load();
+      if (current == table) {
+        return table;
+      }
+      table = current;
+    }
+  }
+
+  // Returns null if the slot is empty or erased, raw is the slot value.
+  // A frozen node is only protected while its table is the root: once the
+  // next table is, the node can be replaced and retired there.
+  Node *ProtectNode(Slot *slot, uintptr_t &raw) {
+    raw = slot->value.load();
+    Node *node = Strip(raw);
+    while (node != nullptr) {
+      node_hp_.AcquireHazardPointer(0, node);
+      raw = slot->value.load();
+      Node *current = Strip(raw);
+      if (current == node) {
+        return node;
+      }
+      node = current;
+    }
+    return nullptr;
+  }
+
+  Slot *FindSlot(Table *table, K key) {
+    size_t mask = table->capacity - 1;
+    size_t index = Index(key) & mask;
+    for (size_t probe = 0; probe < table->capacity; ++probe) {
+      Slot &slot = table->slots[(index + probe) & mask];
+      K current = slot.key.load(std::memory_order_acquire);
+      if (current == key) {
+        return &slot;
+      }
+      if (current == kEmptyKey) {
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // Finds the key or claims an empty slot for it. Returns null if the
+  // table is too full and should be migrated; `migrating` skips that check
+  // for the copy, which always fits.
+  Slot *ClaimSlot(Table *table, K key, bool migrating) {
+    size_t mask = table->capacity - 1;
+    size_t index = Index(key) & mask;
+    for (size_t probe = 0; probe < table->capacity; ++probe) {
+      Slot &slot = table->slots[(index + probe) & mask];
+      K current = slot.key.load(std::memory_order_acquire);
+      if (current == kEmptyKey) {
+        if (!migrating &&
+            table->used.load(std::memory_order_relaxed) >=
+                table->capacity / 4 * 3) {
+          return nullptr;
+        }
+        if (slot.key.compare_exchange_strong(current, key)) {
+          table->used.fetch_add(1, std::memory_order_relaxed);
+          return &slot;
+        }
+      }
+      if (current == key) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  // Stores `value` for the key and returns the node it replaced, null if
+  // none. Without `insert` a missing key is not claimed.
+  Node *Update(K key, uintptr_t value, bool insert) {
+    while (true) {
+      Table *table = ProtectTable();
+      if (table->next.load() != nullptr) {
+        HelpMigrate(table);
+        continue;
+      }
+
+      Slot *slot = insert ? ClaimSlot(table, key, false) : FindSlot(table, key);
+      if (slot == nullptr) {
+        if (!insert) {
+          // Absent, unless a migration has started and moved it already.
+          if (root_.load() == table && table->next.load() == nullptr) {
+            table_hp_.ReleaseHazardPointer(0);
+            return nullptr;
+          }
+          continue;
+        }
+        StartMigration(table);
+        continue;
+      }
+
+      uintptr_t old = slot->value.load();
+      while ((old & kFrozen) == 0) {
+        if (!insert && Strip(old) == nullptr) {
+          table_hp_.ReleaseHazardPointer(0);
+          return nullptr;
+        }
+        if (slot->value.compare_exchange_weak(old, value)) {
+          table_hp_.ReleaseHazardPointer(0);
+          return Strip(old);
+        }
+      }
+      HelpMigrate(table);
+    }
+  }
+
+  void StartMigration(Table *table) {
+    size_t live = size_.load(std::memory_order_relaxed);
+    size_t capacity =
+        live >= table->capacity / 4 ? table->capacity * 2 : table->capacity;
+    Table *next = new Table(capacity);
+    Table *expected = nullptr;
+    if (!table->next.compare_exchange_strong(expected, next)) {
+      delete next;
+    }
+    HelpMigrate(table);
+  }
+
+  // Copies chunks until none is left to claim, copies again those still
+  // unfinished and moves the root on; returns once the root is past table.
+  void HelpMigrate(Table *table) {
+    Table *next = table->next.load();
+    // The next table is only retired after it has become the root.
+    table_hp_.AcquireHazardPointer(2, next);
+    if (root_.load() == table) {
+      size_t chunk;
+      while ((chunk = table->copy_cursor.fetch_add(1)) < table->chunks) {
+        CopyChunk(table, next, chunk);
+      }
+      for (chunk = 0; chunk < table->chunks; ++chunk) {
+        if (!table->copied[chunk].load()) {
+          CopyChunk(table, next, chunk);
+        }
+      }
+      Table *expected = table;
+      if (root_.compare_exchange_strong(expected, next)) {
+        table_hp_.Retire(table);
+      }
+    }
+    table_hp_.ReleaseHazardPointer(2);
+    table_hp_.ReleaseHazardPointer(0);
+  }
+
+  void CopyChunk(Table *table, Table *next, size_t chunk) {
+    size_t end = std::min(table->capacity, (chunk + 1) * kChunk);
+    for (size_t i = chunk * kChunk; i < end; ++i) {
+      Copy(table->slots[i], next);
+    }
+    table->copied[chunk].store(true);
+  }
+
+  void Copy(Slot &slot, Table *next) {
+    uintptr_t value = slot.value.load();
+    while ((value & kFrozen) == 0 &&
+           !slot.value.compare_exchange_weak(value, value | kFrozen)) {
+    }
+    if (Strip(value) == nullptr) {
+      return;
+    }
+    Slot *target = ClaimSlot(next, slot.key.load(), true);
+    assert(target != nullptr);
+    // Fails if another copy got there first, even if the value has been
+    // replaced or erased in the next table since.
+    uintptr_t expected = 0;
+    target->value.compare_exchange_strong(expected, value & ~kFrozen);
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_HASH_MAP_H
@@ -0,0 +1,232 @@
+#ifndef LOCK_FREE_HAZARD_POINTERS_H
+#define LOCK_FREE_HAZARD_POINTERS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cache_line.h"
+#include "lock-free/asymmetric_fence.h"
+
+#define MAX_THREAD_NUM 128
+#define HP_PER_THREAD 2
+
+namespace lock_free {
+
+// Hazard pointer based reclamation of T nodes (Michael, 2004).
+//
+// Every registered thread owns a record with kSlots hazard pointers and a
+// private list of retired nodes. When the list reaches a threshold
+// proportional to the number of hazard pointers in use (2 * H + 16), the
+// thread snapshots all hazard pointers into a sorted vector and frees its
+// retired nodes that are not in it. At least half of the list is freed by
+// each scan, so reclamation costs amortized O(log H) per node and never
+// waits for other threads. Nodes left by an exiting thread go to an orphan
+// list which is adopted by the next scan of any thread.
+//
+// Freed nodes are handed to Deleter, which may recycle them: once a node
+// reaches it no thread can still reach the node.
+template <typename T, size_t kSlots = HP_PER_THREAD,
+          size_t kAlign = kCacheLineSize,
+          typename Deleter = std::default_delete<T>>
+class HazardPointers {
+ public:
+  // tnum is the expected number of client threads, used to presize lists.
+  HazardPointers(size_t tnum, Deleter deleter = Deleter())
+      : expected_threads_(tnum), deleter_(deleter) {}
+
+  HazardPointers(const HazardPointers &) = delete;
+
+  // No thread may use the protected structure any more.
+  ~HazardPointers() {
+    for (auto &record : records_) {
+      for (T *node : record.retired) {
+        deleter_(node);
+      }
+    }
+    for (T *node : orphans_) {
+      deleter_(node);
+    }
+  }
+
+  // Claims a record for the calling thread. Records are recycled by
+  // RemoveThread, so threads may come and go during the structure lifetime.
+  void AddThread() {
+    size_t slot = 0;
+    bool used = false;
+    while (!records_[slot].used.compare_exchange_strong(used, true)) {
+      used = false;
+      ++slot;
+      assert(slot < MAX_THREAD_NUM && "too many threads");
+    }
+
+    size_t hwm = records_hwm_.load();
+    while (hwm < slot + 1 &&
+           !records_hwm_.compare_exchange_weak(hwm, slot + 1)) {
+    }
+    active_threads_.fetch_add(1, std::memory_order_relaxed);
+
+    Record *record = &records_[slot];
+    record->retired.reserve(RetireThreshold());
+
+    for (auto &cached : ThreadRecords()) {
+      if (cached.first == this) {
+        cached.second = record;
+        return;
+      }
+    }
+    ThreadRecords().push_back({this, record});
+  }
+
+  void RemoveThread() {
+    auto &records = ThreadRecords();
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      if (it->first != this) {
+        continue;
+      }
+
+      Record *record = it->second;
+      for (auto &hp : record->hp.value) {
+        hp.store(nullptr, std::memory_order_release);
+      }
+      Scan(record);
+      if (!record->retired.empty()) {
+        std::unique_lock<std::mutex> lock(orphans_lock_);
+        orphans_.insert(orphans_.end(), record->retired.begin(),
+                        record->retired.end());
+        has_orphans_.store(true, std::memory_order_release);
+      }
+      record->retired.clear();
+
+      active_threads_.fetch_sub(1, std::memory_order_relaxed);
+      record->used.store(false);
+      records.erase(it);
+      return;
+    }
+  }
+
+  // The publication is ordered before the caller's validating load by a
+  // store-load fence, see AsymmetricFence for the cheap reader-side mode.
+  void AcquireHazardPointer(size_t ind, T *node) {
+    CurrentRecord()->hp.value[ind].store(node, std::memory_order_relaxed);
+    AsymmetricFence::Light();
+  }
+
+  void ReleaseHazardPointer(size_t ind) {
+    CurrentRecord()->hp.value[ind].store(nullptr, std::memory_order_release);
+  }
+
+  // Registered threads, and records claimed so far: records are recycled,
+  // so the latter stays at the peak number of threads registered at once.
+  size_t GetActiveThreads() const {
+    return active_threads_.load(std::memory_order_relaxed);
+  }
+  size_t GetRecordsUsed() const {
+    return records_hwm_.load(std::memory_order_relaxed);
+  }
+
+  void Retire(T *node) {
+    Record *record = CurrentRecord();
+    record->retired.push_back(node);
+    if (record->retired.size() >= RetireThreshold()) {
+      Scan(record);
+    }
+  }
+
+ private:
+  struct alignas(kAlign) Record {
+    // Read by scanning threads, written by the owner only.
+    CacheLinePadded<std::atomic<T *>[kSlots], kAlign> hp = {};
+    std::atomic_bool used = false;
+    std::vector<T *> retired;
+    std::vector<T *> hazards;  // scan scratch, kept to avoid reallocations
+  };
+
+  const size_t expected_threads_;
+  Deleter deleter_;
+  Record records_[MAX_THREAD_NUM];
+  alignas(kAlign) std::atomic_size_t records_hwm_ = 0;
+  std::atomic_size_t active_threads_ = 0;
+
+  alignas(kAlign) std::atomic_bool has_orphans_ = false;
+  std::mutex orphans_lock_;
+  std::vector<T *> orphans_;
+
+  // Records claimed by the calling thread, one per HazardPointers instance.
+  static std::vector<std::pair<const HazardPointers *, Record *>> &
+  ThreadRecords() {
+    static thread_local std::vector<
+        std::pair<const HazardPointers *, Record *>>
+        records;
+    return records;
+  }
+
+  Record *CurrentRecord() const {
+    for (const auto &cached : ThreadRecords()) {
+      if (cached.first == this) {
+        return cached.second;
+      }
+    }
+    assert(false && "thread is not registered");
+    return nullptr;
+  }
+
+  size_t RetireThreshold() const {
+    size_t threads = std::max(active_threads_.load(std::memory_order_relaxed),
+                              expected_threads_);
+    return 2 * kSlots * threads + 16;
+  }
+
+  void Scan(Record *record) {
+    // Unlinking of the retired nodes must be ordered before reading hazard
+    // pointers; pairs with the fence in AcquireHazardPointer.
+    AsymmetricFence::Heavy();
+
+    AdoptOrphans(record);
+
+    auto &hazards = record->hazards;
+    hazards.clear();
+    size_t hwm = records_hwm_.load(std::memory_order_acquire);
+    for (size_t slot = 0; slot < hwm; ++slot) {
+      for (auto &hp : records_[slot].hp.value) {
+        T *node = hp.load(std::memory_order_acquire);
+        if (node != nullptr) {
+          hazards.push_back(node);
+        }
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    auto &retired = record->retired;
+    auto protected_end = std::partition(
+        retired.begin(), retired.end(), [&hazards](T *node) {
+          return std::binary_search(hazards.begin(), hazards.end(), node);
+        });
+    for (auto it = protected_end; it != retired.end(); ++it) {
+      deleter_(*it);
+    }
+    retired.erase(protected_end, retired.end());
+  }
+
+  void AdoptOrphans(Record *record) {
+    if (!has_orphans_.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(orphans_lock_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    record->retired.insert(record->retired.end(), orphans_.begin(),
+                           orphans_.end());
+    orphans_.clear();
+    has_orphans_.store(false, std::memory_order_relaxed);
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_HAZARD_POINTERS_H
@@ -3,112 +3,30 @@
 
 #include <atomic>
 #include <cassert>
-#include <cstring>
-#include <map>
-#include <set>
+#include <cstdint>
 #include <thread>
+#include <utility>
 
-#define MAX_THREAD_NUM 128
-#define HP_PER_THREAD 2
+#include "cache_line.h"
+#include "lock-free/hazard_pointers.h"
 
 namespace lock_free {
 
-static int ccount = 0;
-
-template <typename T>
-class HazardPointers {
- public:
-  HazardPointers(size_t tnum)
-      : max_count_(2 * HP_PER_THREAD * tnum),
-        client_threads_num_(tnum),
-        scan_is_run_(false) {
-    memset(hp_arr_, 0, MAX_THREAD_NUM * HP_PER_THREAD * sizeof(T*));
-  }
-
-  ~HazardPointers() {
-    Scan();
-  }
-
-  void AddThread(std::thread::id tid) {
-    hp_map_.insert({tid, tcount_++});
-  }
-
-  void AcquireHazardPointer(std::thread::id tid, size_t ind, T* node) {
-    hp_arr_[hp_map_[tid]][ind] = node;
-  }
-
-  void ReleaseHazardPointer(std::thread::id tid, size_t ind) {
-    hp_arr_[hp_map_[tid]][ind] = nullptr;
-  }
-
-  void Retire(T* node) {
-    while (unref_count_ >= max_count_ || scan_is_run_) {
-      ;
-    }
-    unref_nodes_[unref_count_++] = node;
-    if (unref_count_ >= max_count_) {
-      Scan();
-    }
-  }
-
- private:
-  size_t client_threads_num_;
-  size_t max_count_;
-  T* hp_arr_[MAX_THREAD_NUM][HP_PER_THREAD];
-  std::map<std::thread::id, size_t> hp_map_;
-  T* unref_nodes_[4 * HP_PER_THREAD * MAX_THREAD_NUM];
-  std::atomic_size_t unref_count_ = 0;
-
-  std::atomic_bool scan_is_run_;
-
-  std::atomic_size_t tcount_ = 0;
-
-  void Scan() {
-    bool is_run = false;
-    if (!scan_is_run_.compare_exchange_strong(is_run, true,
-                                              std::memory_order_relaxed)) {
-      return;
-    }
-
-    std::set<T*> plist;
-    for (auto& p : hp_map_) {
-      for (int i = 0; i < HP_PER_THREAD; ++i) {
-        if (hp_arr_[p.second][i] != nullptr) {
-          plist.insert(hp_arr_[p.second][i]);
-        }
-      }
-    }
-
-    size_t new_unref_count = 0;
-    T* new_unref_nodes[max_count_ * 2];
-    for (int i = 0; i < unref_count_; ++i) {
-      if (plist.contains(unref_nodes_[i])) {
-        new_unref_nodes[new_unref_count++] = unref_nodes_[i];
-      } else {
-        delete unref_nodes_[i];
-      }
-    }
-
-    for (int i = 0; i < new_unref_count; ++i) {
-      unref_nodes_[i] = new_unref_nodes[i];
-    }
-
-    unref_count_ = new_unref_count;
-    scan_is_run_.store(false, std::memory_order_release);
-  }
-};
-
 template <typename T>
 struct QueueNode {
   QueueNode() : next(nullptr) {}
-  QueueNode(T&& el) : data(std::move(el)), next(nullptr) {}
+  template <typename... Args>
+  explicit QueueNode(std::in_place_t, Args&&... args)
+      : data(std::forward<Args>(args)...), next(nullptr) {}
   T data;
   std::atomic<QueueNode*> next;
 };
 
-template <typename T>
+template <typename T, size_t kAlign = kCacheLineSize>
 class LinkedQueue {
  public:
+  typedef T value_type;
+
   LinkedQueue(size_t tnum) : hp_(tnum) {
     QueueNode<T>* node = new QueueNode<T>;
     head_.store(node, std::memory_order_release);
@@ -125,17 +43,26 @@ class LinkedQueue {
     delete head_;
   }
 
-  void RegisterThread() { hp_.AddThread(std::this_thread::get_id()); }
+  void RegisterThread() { hp_.AddThread(); }
+  void UnregisterThread() { hp_.RemoveThread(); }
+  size_t GetRegisteredThreads() const { return hp_.GetActiveThreads(); }
+  size_t GetHazardRecords() const { return hp_.GetRecordsUsed(); }
 
   bool Enqueue(T&& data) {
     assert(data != nullptr);
-    QueueNode<T>* node = new QueueNode<T>(std::move(data));
-    assert(node->data != nullptr && "xdvxdv");
+    return Emplace(std::move(data));
+  }
+
+  // The element is constructed in its node before it is linked.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    QueueNode<T>* node =
+        new QueueNode<T>(std::in_place, std::forward<Args>(args)...);
 
     QueueNode<T>* t = nullptr;
     while (true) {
       t = tail_.load(std::memory_order_relaxed);
-      hp_.AcquireHazardPointer(std::this_thread::get_id(), 0, t);
+      hp_.AcquireHazardPointer(0, t);
       if (t != tail_.load(std::memory_order_acquire)) {
         continue;
       }
@@ -154,10 +81,11 @@ class LinkedQueue {
                                           std::memory_order_release)) {
         break;
       }
+      cas_failures_.fetch_add(1, std::memory_order_relaxed);
     }
 
     tail_.compare_exchange_strong(t, node, std::memory_order_acq_rel);
-    hp_.ReleaseHazardPointer(std::this_thread::get_id(), 0);
+    hp_.ReleaseHazardPointer(0);
 
     return true;
   }
@@ -168,7 +96,7 @@ class LinkedQueue {
     T* res;
     while (true) {
       head = head_.load(std::memory_order_relaxed);
-      hp_.AcquireHazardPointer(std::this_thread::get_id(), 0, head);
+      hp_.AcquireHazardPointer(0, head);
 
       if (head != head_.load(std::memory_order_acquire)) {
         continue;
@@ -177,7 +105,7 @@ class LinkedQueue {
       QueueNode<T>* tail = tail_.load(std::memory_order_relaxed);
       next = head->next.load(std::memory_order_acquire);
 
-      hp_.AcquireHazardPointer(std::this_thread::get_id(), 1, next);
+      hp_.AcquireHazardPointer(1, next);
 
       if (head != head_.load(std::memory_order_relaxed)) {
         continue;
@@ -185,7 +113,7 @@ class LinkedQueue {
 
       if (next == nullptr) {
         // empty
-        hp_.ReleaseHazardPointer(std::this_thread::get_id(), 0);
+        hp_.ReleaseHazardPointer(0);
         return false;
       }
 
@@ -199,22 +127,32 @@ class LinkedQueue {
                                         std::memory_order_release)) {
         break;
       }
+      cas_failures_.fetch_add(1, std::memory_order_relaxed);
     }
     data = std::move(*res);
 
-    hp_.ReleaseHazardPointer(std::this_thread::get_id(), 0);
-    hp_.ReleaseHazardPointer(std::this_thread::get_id(), 1);
+    hp_.ReleaseHazardPointer(0);
+    hp_.ReleaseHazardPointer(1);
 
     hp_.Retire(head);
 
     return true;
   }
 
+  // Failed CASes on the link and head updates, a measure of contention.
+  // Only counted on the failure path, so uncontended operations don't pay.
+  uint64_t GetCasFailures() const {
+    return cas_failures_.load(std::memory_order_relaxed);
+  }
+
  private:
-  std::atomic<QueueNode<T>*> head_;
-  std::atomic<QueueNode<T>*> tail_;
+  // Consumers work on head_ and producers on tail_, keep them apart.
+  alignas(kAlign) std::atomic<QueueNode<T>*> head_;
+  alignas(kAlign) std::atomic<QueueNode<T>*> tail_;
+
+  alignas(kAlign) std::atomic_uint64_t cas_failures_ = 0;
 
-  HazardPointers<QueueNode<T>> hp_;
+  alignas(kAlign) HazardPointers<QueueNode<T>, HP_PER_THREAD, kAlign> hp_;
 };
 
 }  // namespace lock_free
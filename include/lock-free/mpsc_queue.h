@@ -0,0 +1,190 @@
+#ifndef LOCK_FREE_MPSC_QUEUE_H
+#define LOCK_FREE_MPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "cache_line.h"
+
+namespace lock_free {
+
+// Link embedded in the elements of MpscQueue.
+struct MpscNode {
+  std::atomic<MpscNode *> mpsc_next = nullptr;
+};
+
+// Intrusive multi-producer single-consumer queue (Vyukov). T derives from
+// MpscNode, the queue owns the elements between Enqueue and Dequeue.
+//
+// Enqueue is wait-free: one exchange of tail_ and a store into the
+// previous node. Only the consumer unlinks and frees nodes, so no hazard
+// pointers or other reclamation is needed. A producer preempted between
+// the two steps hides the elements behind its own from the consumer until
+// it resumes, so TryDequeue may fail while the queue is not empty.
+//
+// The consumer can also sleep in Dequeue/DequeueAll; producers then pay a
+// load of sleeping_ and wake it only when it actually sleeps.
+template <typename T>
+class MpscQueue {
+ public:
+  typedef std::unique_ptr<T> value_type;
+
+  MpscQueue() : head_(&stub_), tail_(&stub_), need_stop_(false) {}
+
+  MpscQueue(const MpscQueue &) = delete;
+
+  // No thread may use the queue any more.
+  ~MpscQueue() {
+    value_type data;
+    while (TryDequeue(data)) {
+    }
+  }
+
+  bool Enqueue(value_type &&data) {
+    if (need_stop_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    Push(data.release());
+    WakeConsumer();
+    return true;
+  }
+
+  // Allocates the element from args and queues it.
+  template <typename... Args>
+  bool Emplace(Args &&...args) {
+    if (need_stop_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    Push(new T(std::forward<Args>(args)...));
+    WakeConsumer();
+    return true;
+  }
+
+  // Consumer only.
+  bool TryDequeue(value_type &data) {
+    T *node = Pop();
+    if (node == nullptr) {
+      return false;
+    }
+    data.reset(node);
+    return true;
+  }
+
+  // Consumer only. Appends all available elements to data, returns their
+  // number.
+  size_t TryDequeueAll(std::vector<value_type> &data) {
+    size_t count = 0;
+    while (T *node = Pop()) {
+      data.emplace_back(node);
+      ++count;
+    }
+    return count;
+  }
+
+  // Consumer only. Blocks until an element is available, returns false if
+  // the queue is stopped and empty.
+  bool Dequeue(value_type &data) {
+    while (!TryDequeue(data)) {
+      if (!Wait()) {
+        return TryDequeue(data);
+      }
+    }
+    return true;
+  }
+
+  // Consumer only. Blocking TryDequeueAll, returns 0 if the queue is
+  // stopped and empty.
+  size_t DequeueAll(std::vector<value_type> &data) {
+    while (true) {
+      size_t count = TryDequeueAll(data);
+      if (count > 0) {
+        return count;
+      }
+      if (!Wait()) {
+        return TryDequeueAll(data);
+      }
+    }
+  }
+
+  void Stop() {
+    need_stop_.store(true);
+    WakeConsumer();
+  }
+
+ private:
+  // Consumer side.
+  alignas(kCacheLineSize) MpscNode *head_;
+  std::atomic_bool sleeping_ = false;
+  MpscNode stub_;
+
+  alignas(kCacheLineSize) std::atomic<MpscNode *> tail_;
+  std::atomic_bool need_stop_;
+
+  void Push(MpscNode *node) {
+    node->mpsc_next.store(nullptr, std::memory_order_relaxed);
+    MpscNode *prev = tail_.exchange(node, std::memory_order_acq_rel);
+    prev->mpsc_next.store(node);
+  }
+
+  // head_ is the oldest element unless it is the stub. The last element is
+  // only returned once something is linked after it, which is why the stub
+  // is pushed back when the queue is about to run empty: otherwise a
+  // producer could still write into the returned node.
+  T *Pop() {
+    MpscNode *head = head_;
+    MpscNode *next = head->mpsc_next.load(std::memory_order_acquire);
+    if (head == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      head_ = next;
+      head = next;
+      next = next->mpsc_next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      head_ = next;
+      return static_cast<T *>(head);
+    }
+
+    if (head != tail_.load(std::memory_order_acquire)) {
+      // A producer has taken tail_ but not linked its node yet.
+      return nullptr;
+    }
+    Push(&stub_);
+    next = head->mpsc_next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      head_ = next;
+      return static_cast<T *>(head);
+    }
+    return nullptr;
+  }
+
+  bool Empty() const {
+    return head_ == &stub_ && stub_.mpsc_next.load() == nullptr;
+  }
+
+  // Returns false if the queue is stopped. The seq_cst sleeping_ store and
+  // the load in Empty() pair with the link store in Push and the sleeping_
+  // load in WakeConsumer: either we see the new node or the producer sees
+  // us sleeping.
+  bool Wait() {
+    sleeping_.store(true);
+    if (!need_stop_.load() && Empty()) {
+      sleeping_.wait(true);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+    return !need_stop_.load();
+  }
+
+  void WakeConsumer() {
+    if (sleeping_.load()) {
+      sleeping_.store(false);
+      sleeping_.notify_one();
+    }
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_MPSC_QUEUE_H
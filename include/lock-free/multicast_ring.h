@@ -0,0 +1,285 @@
+#ifndef LOCK_FREE_MULTICAST_RING_H
+#define LOCK_FREE_MULTICAST_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+#include "lock-free/bounded_ring.h"
+
+namespace lock_free {
+
+// Cursor of a MulticastRing consumer: the last sequence it has processed.
+class alignas(kCacheLineSize) Sequence {
+ public:
+  static constexpr int64_t kInitial = -1;
+
+  int64_t Get() const { return value_.load(); }
+  void Set(int64_t value) { value_.store(value); }
+
+ private:
+  std::atomic_int64_t value_ = kInitial;
+};
+
+// Disruptor-style ring (Thompson et al., LMAX, 2011) delivering every
+// event to every consumer instead of to one of them.
+//
+// Producers claim a sequence, fill the slot in place and publish it. Each
+// consumer keeps its own Sequence and reads through a Barrier: a barrier
+// without dependencies follows the published events, one with
+// dependencies follows the slowest of those consumers, so stages form a
+// pipeline over the same slots without copying events between queues.
+// The sequences added with AddGatingSequence, normally those of the last
+// stages, gate wrap-around: a producer waits until the slowest of them has
+// left the slot it claims.
+//
+// With several producers a slot is published by storing its lap number
+// in a side array, so a consumer only reads up to the first gap; a single
+// producer publishes with a plain cursor store and claims without RMW.
+//
+// Waiting yields for a while and then sleeps; producers and consumers pay
+// one load of sleepers_ per publish or batch and wake sleepers only when
+// there are any.
+template <typename T, Producers kProducers = Producers::kMulti>
+class MulticastRing {
+ public:
+  typedef T value_type;
+
+  class Barrier {
+   public:
+    // Returns the highest sequence >= seq that can be read, waiting until
+    // there is one, or seq - 1 once the ring is stopped and everything
+    // published has been returned.
+    int64_t WaitFor(int64_t seq) const {
+      return ring_->WaitFor(seq, dependencies_);
+    }
+
+   private:
+    friend class MulticastRing;
+
+    Barrier(MulticastRing *ring, std::vector<const Sequence *> dependencies)
+        : ring_(ring), dependencies_(std::move(dependencies)) {}
+
+    MulticastRing *ring_;
+    std::vector<const Sequence *> dependencies_;
+  };
+
+  // capacity must be a power of two.
+  explicit MulticastRing(size_t capacity)
+      : mask_(capacity - 1),
+        shift_(std::countr_zero(capacity)),
+        slots_(new T[capacity]) {
+    if (capacity == 0 || (capacity & mask_) != 0) {
+      throw std::invalid_argument(
+          "MulticastRing capacity must be a power of two");
+    }
+    if constexpr (kProducers == Producers::kMulti) {
+      published_.reset(new std::atomic_int64_t[capacity]);
+      for (size_t i = 0; i < capacity; ++i) {
+        published_[i].store(-1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  MulticastRing(const MulticastRing &) = delete;
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // Must be called before the first claim.
+  void AddGatingSequence(const Sequence *sequence) {
+    gating_.push_back(sequence);
+  }
+
+  Barrier NewBarrier(std::vector<const Sequence *> dependencies = {}) {
+    return Barrier(this, std::move(dependencies));
+  }
+
+  // Claims the next sequence, waiting while its slot is still being read.
+  int64_t Claim() {
+    int64_t seq;
+    if constexpr (kProducers == Producers::kMulti) {
+      seq = next_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      seq = next_.load(std::memory_order_relaxed);
+      next_.store(seq + 1, std::memory_order_relaxed);
+    }
+    int64_t wrap = seq - static_cast<int64_t>(Capacity());
+    if (wrap > gating_cache_.load(std::memory_order_relaxed)) {
+      int64_t gating;
+      Wait([&] { return (gating = MinGating()) >= wrap; });
+      gating_cache_.store(gating, std::memory_order_relaxed);
+    }
+    return seq;
+  }
+
+  // Claims the next sequence if its slot is free.
+  bool TryClaim(int64_t &seq) {
+    seq = next_.load(std::memory_order_relaxed);
+    while (true) {
+      int64_t wrap = seq - static_cast<int64_t>(Capacity());
+      if (wrap > gating_cache_.load(std::memory_order_relaxed)) {
+        int64_t gating = MinGating();
+        gating_cache_.store(gating, std::memory_order_relaxed);
+        if (wrap > gating) {
+          return false;
+        }
+      }
+      if constexpr (kProducers == Producers::kMulti) {
+        if (next_.compare_exchange_weak(seq, seq + 1,
+                                        std::memory_order_relaxed)) {
+          return true;
+        }
+      } else {
+        next_.store(seq + 1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  // Consumers of one stage run concurrently on the same slot, so they may
+  // only modify the event if no other consumer of the stage reads it.
+  T &Get(int64_t seq) { return slots_[seq & mask_]; }
+
+  void Publish(int64_t seq) {
+    if constexpr (kProducers == Producers::kMulti) {
+      published_[seq & mask_].store(seq >> shift_);
+    } else {
+      cursor_.store(seq);
+    }
+    Signal();
+  }
+
+  // Runs handler(event, end_of_batch) on every event the barrier lets
+  // through and advances sequence after each batch. Returns when the ring
+  // is stopped and the events are exhausted.
+  template <typename Handler>
+  void Process(const Barrier &barrier, Sequence &sequence, Handler handler) {
+    int64_t next = sequence.Get() + 1;
+    while (true) {
+      int64_t available = barrier.WaitFor(next);
+      if (available < next) {
+        return;
+      }
+      for (; next <= available; ++next) {
+        handler(Get(next), next == available);
+      }
+      sequence.Set(available);
+      Signal();
+    }
+  }
+
+  // Producers must not publish any more.
+  void Stop() {
+    stopped_.store(true);
+    Signal();
+  }
+
+ private:
+  static constexpr size_t kYields = 64;
+
+  const size_t mask_;
+  const int shift_;
+  std::unique_ptr<T[]> slots_;
+  // Lap number of the last event published in each slot, kMulti only.
+  std::unique_ptr<std::atomic_int64_t[]> published_;
+  std::vector<const Sequence *> gating_;
+
+  alignas(kCacheLineSize) std::atomic_int64_t next_ = 0;
+  std::atomic_int64_t gating_cache_ = Sequence::kInitial;
+  // Last published sequence, kSingle only.
+  alignas(kCacheLineSize) std::atomic_int64_t cursor_ = Sequence::kInitial;
+
+  alignas(kCacheLineSize) std::atomic_uint32_t sleepers_ = 0;
+  std::atomic_uint32_t signal_ = 0;
+  std::atomic_bool stopped_ = false;
+
+  int64_t MinGating() const {
+    int64_t min = std::numeric_limits<int64_t>::max();
+    for (const Sequence *sequence : gating_) {
+      min = std::min(min, sequence->Get());
+    }
+    return min;
+  }
+
+  // Highest sequence published without a gap from seq on.
+  int64_t Published(int64_t seq) const {
+    if constexpr (kProducers == Producers::kMulti) {
+      int64_t claimed = next_.load() - 1;
+      for (; seq <= claimed; ++seq) {
+        if (published_[seq & mask_].load() != (seq >> shift_)) {
+          return seq - 1;
+        }
+      }
+      return claimed;
+    } else {
+      return cursor_.load();
+    }
+  }
+
+  int64_t Available(int64_t seq,
+                    const std::vector<const Sequence *> &dependencies) const {
+    if (dependencies.empty()) {
+      return Published(seq);
+    }
+    int64_t min = std::numeric_limits<int64_t>::max();
+    for (const Sequence *sequence : dependencies) {
+      min = std::min(min, sequence->Get());
+    }
+    return min;
+  }
+
+  // A stopped ring still lets a stage through what its dependencies have
+  // yet to process; only when nothing is published at seq can it end.
+  int64_t WaitFor(int64_t seq,
+                  const std::vector<const Sequence *> &dependencies) {
+    int64_t available;
+    Wait([&] {
+      available = Available(seq, dependencies);
+      return available >= seq || (stopped_.load() && Published(seq) < seq);
+    });
+    return std::max(available, seq - 1);
+  }
+
+  // The seq_cst sleepers_ increment and the loads in ready() pair with the
+  // seq_cst publish/sequence stores and the sleepers_ load in Signal():
+  // either the waiter sees the update or the updater sees the waiter. A
+  // signal between the epoch load and the wait changes the epoch.
+  template <typename Ready>
+  void Wait(Ready ready) {
+    for (size_t i = 0; i < kYields; ++i) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    while (true) {
+      sleepers_.fetch_add(1);
+      uint32_t epoch = signal_.load();
+      if (ready()) {
+        sleepers_.fetch_sub(1);
+        return;
+      }
+      signal_.wait(epoch);
+      sleepers_.fetch_sub(1);
+    }
+  }
+
+  void Signal() {
+    if (sleepers_.load() != 0) {
+      signal_.fetch_add(1);
+      signal_.notify_all();
+    }
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_MULTICAST_RING_H
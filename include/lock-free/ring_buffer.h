@@ -1,22 +1,35 @@
 #ifndef LOCK_FREE_RING_BUFFER_H
 #define LOCK_FREE_RING_BUFFER_H
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <vector>
 
+#include "cache_line.h"
+
 namespace lock_free {
 
-template <typename T>
+// Holds buff_size elements in a buffer rounded up to a power of two, so
+// indices wrap with a mask instead of a divide.
+template <typename T, size_t kAlign = kCacheLineSize>
 class RingBuffer {
  public:
   RingBuffer(size_t buff_size)
       : head_idx_(0), tail_idx_(0), used_(0), free_(buff_size) {
-    buffer_.resize(buff_size);
+    buffer_.resize(std::bit_ceil(std::max<size_t>(buff_size, 1)));
+    mask_ = buffer_.size() - 1;
+  }
+
+  // Slots hold live elements, the new one is assigned over the old one.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Enqueue(T(std::forward<Args>(args)...));
   }
 
   bool Enqueue(T&& data) {
     size_t widx = AcquireWrite();
-    buffer_[widx % buffer_.size()] = std::move(data);
+    buffer_[widx] = std::move(data);
     ReleaseWrite();
     return true;
   }
@@ -27,7 +40,7 @@ class RingBuffer {
       return false;
     }
 
-    buffer_[widx % buffer_.size()] = std::move(data);
+    buffer_[widx] = std::move(data);
     ReleaseWrite();
     return true;
   }
@@ -53,13 +66,16 @@ class RingBuffer {
   }
 
  private:
-  std::atomic_size_t head_idx_;
-  std::atomic_size_t tail_idx_;
+  // Each hot index and counter gets its own cache line; buffer_ itself is
+  // read-mostly and kept away from them too.
+  alignas(kAlign) std::atomic_size_t head_idx_;
+  alignas(kAlign) std::atomic_size_t tail_idx_;
 
-  std::atomic_int used_;
-  std::atomic_int free_;
+  alignas(kAlign) std::atomic_int used_;
+  alignas(kAlign) std::atomic_int free_;
 
-  std::vector<T> buffer_;
+  alignas(kAlign) std::vector<T> buffer_;
+  size_t mask_;
 
   static_assert(std::atomic<size_t>::is_always_lock_free);
   static_assert(std::atomic<int>::is_always_lock_free);
@@ -71,7 +87,7 @@ class RingBuffer {
         // spin until success
       }
 
-      size_t new_tail = (old_tail + 1) % buffer_.size();
+      size_t new_tail = (old_tail + 1) & mask_;
       free_--;
       if (tail_idx_.compare_exchange_strong(old_tail, new_tail)) {
         return old_tail;
@@ -87,7 +103,7 @@ class RingBuffer {
         return buffer_.size() + 1;
       }
 
-      size_t new_tail = (old_tail + 1) % buffer_.size();
+      size_t new_tail = (old_tail + 1) & mask_;
       free_--;
       if (tail_idx_.compare_exchange_strong(old_tail, new_tail)) {
         return old_tail;
@@ -105,7 +121,7 @@ class RingBuffer {
         // spin until success
       }
 
-      size_t new_head = (old_head + 1) % buffer_.size();
+      size_t new_head = (old_head + 1) & mask_;
       used_--;
       if (head_idx_.compare_exchange_strong(old_head, new_head))
         return old_head;
@@ -121,7 +137,7 @@ class RingBuffer {
         return buffer_.size() + 1;
       }
 
-      size_t new_head = (old_head + 1) % buffer_.size();
+      size_t new_head = (old_head + 1) & mask_;
       used_--;
       if (head_idx_.compare_exchange_strong(old_head, new_head))
         return old_head;
@@ -0,0 +1,164 @@
+#ifndef LOCK_FREE_SEGMENTED_VECTOR_H
+#define LOCK_FREE_SEGMENTED_VECTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "cache_line.h"
+
+namespace lock_free {
+
+// Append-only vector for any number of concurrent writers and readers.
+//
+// A writer reserves an index with one fetch_add on size_, constructs the
+// element in its slot and publishes it with a release store of the slot's
+// ready flag. Slots live in segments that double in size: segment k holds
+// kFirstSegment << k elements, so an index maps to its segment with a bit
+// scan and elements never move once constructed. The writer reaching the
+// middle of a segment allocates the next one, so writers rarely find their
+// segment missing; if they do, each allocates one, they CAS the pointer in
+// and the losers free theirs.
+//
+// Readers see an element once its flag is set: At returns null for a
+// reserved slot that is not published yet, ForEach skips it. After the
+// writers are joined every element below Size() is published.
+template <typename T, size_t kFirstSegment = 1024>
+class SegmentedVector {
+ public:
+  static_assert(std::has_single_bit(kFirstSegment),
+                "kFirstSegment must be a power of two");
+
+  typedef T value_type;
+
+  SegmentedVector() : size_(0) {
+    for (auto &segment : segments_) {
+      segment.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  SegmentedVector(const SegmentedVector &) = delete;
+
+  // No thread may use the vector any more.
+  ~SegmentedVector() {
+    for (size_t k = 0; k < kMaxSegments; ++k) {
+      Slot *segment = segments_[k].load(std::memory_order_relaxed);
+      if (segment == nullptr) {
+        continue;
+      }
+      for (size_t i = 0; i < SegmentSize(k); ++i) {
+        if (segment[i].ready) {
+          segment[i].Get()->~T();
+        }
+      }
+      std::free(segment);
+    }
+  }
+
+  // Returns the index of the new element.
+  template <typename... Args>
+  size_t EmplaceBack(Args &&...args) {
+    size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+    size_t k = SegmentOf(index);
+    Slot &slot = ClaimSegment(k)[index - SegmentBase(k)];
+    if (index - SegmentBase(k) == SegmentSize(k) / 2 && k + 1 < kMaxSegments) {
+      ClaimSegment(k + 1);
+    }
+    new (slot.storage) T(std::forward<Args>(args)...);
+    slot.Ready().store(true, std::memory_order_release);
+    return index;
+  }
+
+  size_t PushBack(T &&value) { return EmplaceBack(std::move(value)); }
+  size_t PushBack(const T &value) { return EmplaceBack(value); }
+
+  // Number of reserved indices, published or not.
+  size_t Size() const { return size_.load(std::memory_order_acquire); }
+
+  // Null if the element is not published yet.
+  const T *At(size_t index) const {
+    Slot *slot = FindSlot(index);
+    if (slot == nullptr || !slot->Ready().load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return slot->Get();
+  }
+
+  // Calls f(index, element) for the published elements in index order.
+  template <typename F>
+  void ForEach(F f) const {
+    size_t size = Size();
+    for (size_t k = 0; k < kMaxSegments && SegmentBase(k) < size; ++k) {
+      Slot *segment = segments_[k].load(std::memory_order_acquire);
+      if (segment == nullptr) {
+        continue;
+      }
+      size_t end = std::min(SegmentSize(k), size - SegmentBase(k));
+      for (size_t i = 0; i < end; ++i) {
+        if (segment[i].Ready().load(std::memory_order_acquire)) {
+          f(SegmentBase(k) + i, static_cast<const T &>(*segment[i].Get()));
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kFirstShift = std::countr_zero(kFirstSegment);
+  static constexpr size_t kMaxSegments = 64 - kFirstShift;
+
+  // Trivial, so that a zeroed allocation is a segment of empty slots: big
+  // segments come from calloc as untouched zero pages and are only faulted
+  // in as writers reach them.
+  struct Slot {
+    bool ready;
+    alignas(T) std::byte storage[sizeof(T)];
+
+    std::atomic_ref<bool> Ready() { return std::atomic_ref<bool>(ready); }
+    T *Get() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+  static_assert(alignof(Slot) <= alignof(std::max_align_t));
+
+  static constexpr size_t SegmentSize(size_t k) { return kFirstSegment << k; }
+  static constexpr size_t SegmentBase(size_t k) {
+    return (kFirstSegment << k) - kFirstSegment;
+  }
+  static size_t SegmentOf(size_t index) {
+    return std::bit_width((index >> kFirstShift) + 1) - 1;
+  }
+
+  alignas(kCacheLineSize) std::atomic_size_t size_;
+  alignas(kCacheLineSize) std::atomic<Slot *> segments_[kMaxSegments];
+
+  Slot *FindSlot(size_t index) const {
+    size_t k = SegmentOf(index);
+    Slot *segment = segments_[k].load(std::memory_order_acquire);
+    return segment != nullptr ? &segment[index - SegmentBase(k)] : nullptr;
+  }
+
+  // Returns segment k, allocating it if nobody has yet.
+  Slot *ClaimSegment(size_t k) {
+    Slot *segment = segments_[k].load(std::memory_order_acquire);
+    if (segment == nullptr) {
+      Slot *fresh =
+          static_cast<Slot *>(std::calloc(SegmentSize(k), sizeof(Slot)));
+      if (fresh == nullptr) {
+        throw std::bad_alloc();
+      }
+      if (segments_[k].compare_exchange_strong(segment, fresh,
+                                               std::memory_order_acq_rel)) {
+        segment = fresh;
+      } else {
+        std::free(fresh);
+      }
+    }
+    return segment;
+  }
+};
+
+}  // namespace lock_free
+
+#endif  // LOCK_FREE_SEGMENTED_VECTOR_H
@@ -0,0 +1,158 @@
+#ifndef LOCK_BLOCK_QUEUE_H
+#define LOCK_BLOCK_QUEUE_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "cache_line.h"
+
+namespace locks {
+
+// Unbounded sequential queue keeping kBlockSize elements per cache-aligned
+// block. Enqueue and Dequeue only move an index inside the current block,
+// a block is allocated once per kBlockSize elements and dequeues walk
+// memory sequentially instead of chasing a pointer per element. Drained
+// blocks go to a freelist of up to kMaxFreeBlocks, so a queue oscillating
+// around a steady size stops allocating, and a queue that runs empty
+// rewinds its last block instead of releasing it.
+//
+// Not thread safe, same interface as LinkedQueue.
+template <typename T, size_t kBlockSize = 64>
+class BlockQueue {
+ public:
+  BlockQueue()
+      : head_(nullptr),
+        tail_(nullptr),
+        head_pos_(0),
+        tail_pos_(0),
+        size_(0),
+        free_(nullptr),
+        free_num_(0) {}
+
+  BlockQueue(const BlockQueue &) = delete;
+
+  ~BlockQueue() {
+    while (size_ > 0) {
+      head_->Slot(head_pos_)->~T();
+      Pop();
+    }
+    DeleteBlocks(head_);
+    DeleteBlocks(free_);
+  }
+
+  bool Empty() const { return size_ == 0; }
+
+  size_t Size() const { return size_; }
+
+  void Swap(BlockQueue &other) {
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(head_pos_, other.head_pos_);
+    std::swap(tail_pos_, other.tail_pos_);
+    std::swap(size_, other.size_);
+    std::swap(free_, other.free_);
+    std::swap(free_num_, other.free_num_);
+  }
+
+  bool Enqueue(T &&data) { return Emplace(std::move(data)); }
+
+  template <typename... Args>
+  bool Emplace(Args &&...args) {
+    if (tail_ == nullptr) {
+      head_ = tail_ = NewBlock();
+    } else if (tail_pos_ == kBlockSize) {
+      tail_->next = NewBlock();
+      tail_ = tail_->next;
+      tail_pos_ = 0;
+    }
+    new (tail_->Slot(tail_pos_)) T(std::forward<Args>(args)...);
+    ++tail_pos_;
+    ++size_;
+
+    return true;
+  }
+
+  bool Dequeue(T &data) {
+    if (Empty()) {
+      return false;
+    }
+    T *slot = head_->Slot(head_pos_);
+    data = std::move(*slot);
+    slot->~T();
+    Pop();
+
+    return true;
+  }
+
+ private:
+  static constexpr size_t kMaxFreeBlocks = 2;
+
+  struct alignas(kCacheLineSize) Block {
+    Block *next = nullptr;
+    alignas(T) std::byte storage[sizeof(T) * kBlockSize];
+
+    T *Slot(size_t pos) {
+      return std::launder(reinterpret_cast<T *>(storage) + pos);
+    }
+  };
+
+  Block *head_;
+  Block *tail_;
+  size_t head_pos_;
+  size_t tail_pos_;
+  size_t size_;
+  Block *free_;
+  size_t free_num_;
+
+  // Advances past the head element, which is already destroyed.
+  void Pop() {
+    ++head_pos_;
+    --size_;
+    if (size_ == 0) {
+      // The head block is the tail one, start it over.
+      assert(head_ == tail_);
+      head_pos_ = 0;
+      tail_pos_ = 0;
+    } else if (head_pos_ == kBlockSize) {
+      Block *block = head_;
+      head_ = head_->next;
+      head_pos_ = 0;
+      Recycle(block);
+    }
+  }
+
+  Block *NewBlock() {
+    if (free_ == nullptr) {
+      return new Block;
+    }
+    Block *block = free_;
+    free_ = block->next;
+    --free_num_;
+    block->next = nullptr;
+    return block;
+  }
+
+  void Recycle(Block *block) {
+    if (free_num_ == kMaxFreeBlocks) {
+      delete block;
+      return;
+    }
+    block->next = free_;
+    free_ = block;
+    ++free_num_;
+  }
+
+  static void DeleteBlocks(Block *block) {
+    while (block != nullptr) {
+      Block *next = block->next;
+      delete block;
+      block = next;
+    }
+  }
+};
+
+}  // namespace locks
+
+#endif  // LOCK_BLOCK_QUEUE_H
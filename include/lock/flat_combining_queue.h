@@ -0,0 +1,169 @@
+#ifndef LOCK_FLAT_COMBINING_QUEUE_H
+#define LOCK_FLAT_COMBINING_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+#include "lock/lock_policies.h"
+
+namespace locks {
+
+// Flat-combining queue (Hendler, Incze, Shavit and Tzafrir, 2010). A
+// thread publishes its operation in its own record and tries to become the
+// combiner; the combiner runs every pending operation on a sequential
+// std::deque and marks the records done, the others wait on their record.
+// The deque is only touched by the combiner, so it stays in one cache and
+// there are no failed CASes on shared head/tail pointers, at the price of
+// serializing all operations.
+//
+// It pays off when many threads hammer the queue at once, with few threads
+// or work between operations a thread mostly combines alone and the
+// publication round trip is pure overhead.
+template <typename T>
+class FlatCombiningQueue {
+ public:
+  typedef T value_type;
+
+  // The thread number is not needed, the parameter keeps the constructor
+  // of the lock-free queues.
+  FlatCombiningQueue(size_t = 0) : records_hwm_(0) {}
+
+  FlatCombiningQueue(const FlatCombiningQueue&) = delete;
+
+  void RegisterThread() {
+    size_t slot = 0;
+    bool used = false;
+    while (!records_[slot].used.compare_exchange_strong(used, true)) {
+      used = false;
+      ++slot;
+      assert(slot < kMaxThreads && "too many threads");
+    }
+
+    size_t hwm = records_hwm_.load();
+    while (hwm < slot + 1 &&
+           !records_hwm_.compare_exchange_weak(hwm, slot + 1)) {
+    }
+
+    for (auto& cached : ThreadRecords()) {
+      if (cached.first == this) {
+        cached.second = &records_[slot];
+        return;
+      }
+    }
+    ThreadRecords().push_back({this, &records_[slot]});
+  }
+
+  void UnregisterThread() {
+    auto& records = ThreadRecords();
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      if (it->first == this) {
+        it->second->used.store(false);
+        records.erase(it);
+        return;
+      }
+    }
+  }
+
+  bool Enqueue(T&& data) { return Apply(kEnqueue, &data); }
+
+  // Records carry a pointer to a ready element, so it is built here and
+  // moved into the deque by the combiner.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    T data(std::forward<Args>(args)...);
+    return Apply(kEnqueue, &data);
+  }
+
+  bool TryDequeue(T& data) { return Apply(kDequeue, &data); }
+
+ private:
+  static constexpr size_t kMaxThreads = 128;
+  static constexpr size_t kCombinePasses = 2;
+
+  enum Op : uint8_t { kEnqueue, kDequeue };
+  enum State : uint8_t { kIdle, kPending, kDone };
+
+  struct alignas(kCacheLineSize) Record {
+    std::atomic<State> state = kIdle;
+    Op op = kEnqueue;
+    T* data = nullptr;
+    bool result = false;
+    std::atomic_bool used = false;
+  };
+
+  Record records_[kMaxThreads];
+  alignas(kCacheLineSize) std::atomic_size_t records_hwm_;
+  alignas(kCacheLineSize) TtasLock combiner_lock_;
+  // Accessed by the combiner only.
+  alignas(kCacheLineSize) std::deque<T> queue_;
+
+  static std::vector<std::pair<const FlatCombiningQueue*, Record*>>&
+  ThreadRecords() {
+    static thread_local std::vector<
+        std::pair<const FlatCombiningQueue*, Record*>>
+        records;
+    return records;
+  }
+
+  Record* CurrentRecord() const {
+    for (const auto& cached : ThreadRecords()) {
+      if (cached.first == this) {
+        return cached.second;
+      }
+    }
+    assert(false && "thread is not registered");
+    return nullptr;
+  }
+
+  bool Apply(Op op, T* data) {
+    Record* record = CurrentRecord();
+    record->op = op;
+    record->data = data;
+    record->state.store(kPending, std::memory_order_release);
+
+    Backoff backoff;
+    while (record->state.load(std::memory_order_acquire) != kDone) {
+      if (combiner_lock_.try_lock()) {
+        Combine();
+        combiner_lock_.unlock();
+      } else {
+        backoff.Pause();
+      }
+    }
+
+    record->state.store(kIdle, std::memory_order_relaxed);
+    return record->result;
+  }
+
+  void Combine() {
+    size_t hwm = records_hwm_.load(std::memory_order_acquire);
+    for (size_t pass = 0; pass < kCombinePasses; ++pass) {
+      for (size_t slot = 0; slot < hwm; ++slot) {
+        Record& record = records_[slot];
+        if (record.state.load(std::memory_order_acquire) != kPending) {
+          continue;
+        }
+        if (record.op == kEnqueue) {
+          queue_.push_back(std::move(*record.data));
+          record.result = true;
+        } else if (queue_.empty()) {
+          record.result = false;
+        } else {
+          *record.data = std::move(queue_.front());
+          queue_.pop_front();
+          record.result = true;
+        }
+        record.state.store(kDone, std::memory_order_release);
+      }
+    }
+  }
+};
+
+}  // namespace locks
+
+#endif  // LOCK_FLAT_COMBINING_QUEUE_H
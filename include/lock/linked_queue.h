@@ -2,13 +2,21 @@
 #define LOCK_LINKED_QUEUE_H
 
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#include "lock/block_queue.h"
+#include "lock/lock_policies.h"
 
 namespace locks {
 
 template <typename T>
 struct QueueNode {
-  QueueNode(T&& el) : data(std::move(el)), next(nullptr) {}
+  template <typename... Args>
+  explicit QueueNode(std::in_place_t, Args&&... args)
+      : data(std::forward<Args>(args)...), next(nullptr) {}
   T data;
   QueueNode *next;
 };
@@ -16,13 +24,37 @@ struct QueueNode {
 template <typename T>
 class LinkedQueue {
  public:
-  LinkedQueue() : head_(nullptr), tail_(nullptr) {}
+  LinkedQueue() : head_(nullptr), tail_(nullptr), size_(0) {}
+
+  LinkedQueue(const LinkedQueue&) = delete;
+
+  ~LinkedQueue() {
+    while (head_ != nullptr) {
+      QueueNode<T> *tmp = head_;
+      head_ = head_->next;
+      delete tmp;
+    }
+  }
 
   bool Empty() const { return head_ == nullptr && tail_ == nullptr; }
 
-  bool Enqueue(T&& data) {
+  size_t Size() const { return size_; }
+
+  void Swap(LinkedQueue& other) {
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(size_, other.size_);
+  }
+
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  // Constructs the element in its node.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    QueueNode<T> *node =
+        new QueueNode<T>(std::in_place, std::forward<Args>(args)...);
     if (Empty()) {
-      head_ = new QueueNode(std::move(data));
+      head_ = node;
       tail_ = head_;
     } else {
       if (tail_ == nullptr) {
@@ -31,9 +63,10 @@ class LinkedQueue {
         return false;
       }
       assert(tail_->next == nullptr);
-      tail_->next = new QueueNode(std::move(data));
+      tail_->next = node;
       tail_ = tail_->next;
     }
+    ++size_;
 
     return true;
   }
@@ -52,6 +85,7 @@ class LinkedQueue {
     }
 
     delete tmp;
+    --size_;
 
     return true;
   }
@@ -59,35 +93,52 @@ class LinkedQueue {
  private:
   QueueNode<T> *head_;
   QueueNode<T> *tail_;
+  size_t size_;
 };
 
-template <typename T>
+// Lock is std::mutex or one of the policies from lock_policies.h.
+// Sequential is the queue kept under the lock: BlockQueue by default,
+// LinkedQueue for the node-per-element baseline.
+template <typename T, typename Lock = std::mutex,
+          typename Sequential = BlockQueue<T>>
 class LinkedQueueThreadSafe {
  public:
+  typedef T value_type;
+
   LinkedQueueThreadSafe()
-      : lqueue_(), need_stop_(false) {}
+      : lqueue_(), need_stop_(false), waiters_(0) {}
 
   ~LinkedQueueThreadSafe() {}
 
-  bool Enqueue(T&& data) {
-    std::unique_lock<std::mutex> lock(buff_lock_);
-    if (need_stop_) {
-      return false;
-    }
+  // Consumers are only notified when some of them sleep, and after the
+  // unlock so that the woken thread does not block on buff_lock_ again.
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  // The element is constructed under the lock, in its final place.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    bool notify;
+    {
+      std::unique_lock<Lock> lock(buff_lock_);
+      if (need_stop_) {
+        return false;
+      }
 
-    bool res = lqueue_.Enqueue(std::move(data));
-    assert(res);
+      bool res = lqueue_.Emplace(std::forward<Args>(args)...);
+      assert(res);
+      notify = waiters_ > 0;
+    }
 
-    buff_is_not_empty_condition_.notify_one();
+    if (notify) {
+      buff_is_not_empty_condition_.notify_one();
+    }
 
-    return res;
+    return true;
   }
 
   bool Dequeue(T& data) {
-    std::unique_lock<std::mutex> lock(buff_lock_);
-    buff_is_not_empty_condition_.wait(lock, [this] {
-      return std::forward<bool>(need_stop_) || !lqueue_.Empty();
-    });
+    std::unique_lock<Lock> lock(buff_lock_);
+    WaitNotEmpty(lock);
     if (need_stop_ && lqueue_.Empty()) {
       return false;
     }
@@ -98,17 +149,73 @@ class LinkedQueueThreadSafe {
     return res;
   }
 
+  // Takes all queued elements at once by swapping the list out, data must
+  // be empty. Blocks like Dequeue, returns the number of elements taken, 0
+  // if the queue is stopped and empty.
+  size_t DequeueAll(Sequential& data) {
+    assert(data.Empty());
+    std::unique_lock<Lock> lock(buff_lock_);
+    WaitNotEmpty(lock);
+    lqueue_.Swap(data);
+
+    return data.Size();
+  }
+
+  bool TryDequeue(T& data) {
+    std::unique_lock<Lock> lock(buff_lock_);
+    return lqueue_.Dequeue(data);
+  }
+
+  // Returns false on timeout or if the queue is stopped and empty.
+  template <typename Rep, typename Period>
+  bool DequeueFor(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<Lock> lock(buff_lock_);
+    if (!need_stop_ && lqueue_.Empty()) {
+      ++waiters_;
+      buff_is_not_empty_condition_.wait_for(lock, timeout, [this] {
+        return std::forward<bool>(need_stop_) || !lqueue_.Empty();
+      });
+      --waiters_;
+    }
+    return lqueue_.Dequeue(data);
+  }
+
+  const Lock &GetLock() const { return buff_lock_; }
+
+  LockStatsTotal GetLockStats() const
+    requires requires(const Lock& lock) { lock.GetStats(); }
+  {
+    LockStatsTotal total;
+    total.Add(buff_lock_.GetStats());
+    return total;
+  }
+
   void Stop() {
-    need_stop_ = true;
+    {
+      std::unique_lock<Lock> lock(buff_lock_);
+      need_stop_ = true;
+    }
     buff_is_not_empty_condition_.notify_all();
   }
 
  private:
-  LinkedQueue<T> lqueue_;
+  Sequential lqueue_;
 
   std::atomic_bool need_stop_;
-  std::mutex buff_lock_;
-  std::condition_variable buff_is_not_empty_condition_;
+  size_t waiters_;  // guarded by buff_lock_
+  Lock buff_lock_;
+  ConditionVariableFor<Lock> buff_is_not_empty_condition_;
+
+  void WaitNotEmpty(std::unique_lock<Lock>& lock) {
+    if (need_stop_ || !lqueue_.Empty()) {
+      return;
+    }
+    ++waiters_;
+    buff_is_not_empty_condition_.wait(lock, [this] {
+      return std::forward<bool>(need_stop_) || !lqueue_.Empty();
+    });
+    --waiters_;
+  }
 };
 
 }  // namespace locks
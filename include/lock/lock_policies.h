@@ -0,0 +1,401 @@
+#ifndef LOCK_LOCK_POLICIES_H
+#define LOCK_LOCK_POLICIES_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "cache_line.h"
+
+// Lock policies for the locks::*ThreadSafe queues. Every policy is a
+// BasicLockable (lock/try_lock/unlock) so it works with std::unique_lock
+// and std::condition_variable_any, and keeps LockStats. The clock is only
+// read when the fast path fails, so uncontended acquisitions stay cheap.
+namespace locks {
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Updated by the lock holder only, so plain load/store pairs are enough;
+// readers get a tear-free, possibly stale value.
+class LockStats {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  void Acquired() { Add(acquisitions_, 1); }
+
+  void Waited(Clock::time_point since) {
+    Add(contended_, 1);
+    Add(wait_ns_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      Clock::now() - since)
+                      .count());
+  }
+
+  uint64_t GetAcquisitions() const {
+    return acquisitions_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetContended() const {
+    return contended_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetWaitNs() const {
+    return wait_ns_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic_uint64_t acquisitions_ = 0;
+  std::atomic_uint64_t contended_ = 0;
+  std::atomic_uint64_t wait_ns_ = 0;
+
+  static void Add(std::atomic_uint64_t &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+};
+
+// Sum of the stats of several locks, e.g. all the locks of a queue.
+struct LockStatsTotal {
+  uint64_t acquisitions = 0;
+  uint64_t contended = 0;
+  uint64_t wait_ns = 0;
+
+  void Add(const LockStats &stats) {
+    acquisitions += stats.GetAcquisitions();
+    contended += stats.GetContended();
+    wait_ns += stats.GetWaitNs();
+  }
+};
+
+// Spins while waiting, with exponential backoff and a yield once the
+// backoff is at its cap so a preempted holder can run.
+class Backoff {
+ public:
+  static constexpr uint32_t kMaxSpins = 1024;
+
+  explicit Backoff(uint32_t max_spins = kMaxSpins) : max_spins_(max_spins) {}
+
+  void Pause() {
+    if (spins_ < max_spins_) {
+      for (uint32_t i = 0; i < spins_; ++i) {
+        CpuRelax();
+      }
+      spins_ *= 2;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  const uint32_t max_spins_;
+  uint32_t spins_ = 1;
+};
+
+// Spin cap of the FIFO locks. Their waiters cannot overtake the one at the
+// head of the line, so once that one is preempted spinning only delays it
+// further; they yield after about one critical section instead.
+constexpr uint32_t kFifoMaxSpins = 64;
+
+// std::mutex with LockStats.
+class MutexLock {
+ public:
+  void lock() {
+    if (!mutex_.try_lock()) {
+      auto ts = LockStats::Clock::now();
+      mutex_.lock();
+      stats_.Waited(ts);
+    }
+    stats_.Acquired();
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    stats_.Acquired();
+    return true;
+  }
+
+  void unlock() { mutex_.unlock(); }
+
+  const LockStats &GetStats() const { return stats_; }
+
+ private:
+  std::mutex mutex_;
+  LockStats stats_;
+};
+
+// Test-and-test-and-set spinlock: waiters spin on a plain load and only
+// attempt the exchange when the lock looks free.
+class TtasLock {
+ public:
+  void lock() {
+    if (!Acquire()) {
+      auto ts = LockStats::Clock::now();
+      Backoff backoff;
+      do {
+        while (locked_.load(std::memory_order_relaxed)) {
+          backoff.Pause();
+        }
+      } while (!Acquire());
+      stats_.Waited(ts);
+    }
+    stats_.Acquired();
+  }
+
+  bool try_lock() {
+    if (locked_.load(std::memory_order_relaxed) || !Acquire()) {
+      return false;
+    }
+    stats_.Acquired();
+    return true;
+  }
+
+  void unlock() { locked_.store(false, std::memory_order_release); }
+
+  const LockStats &GetStats() const { return stats_; }
+
+ private:
+  std::atomic_bool locked_ = false;
+  LockStats stats_;
+
+  bool Acquire() {
+    return !locked_.exchange(true, std::memory_order_acquire);
+  }
+};
+
+// FIFO ticket lock. Waiters back off proportionally to their distance
+// from the head of the line and yield once the line stops moving.
+class TicketLock {
+ public:
+  void lock() {
+    uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t serving = serving_.load(std::memory_order_acquire);
+    if (serving != ticket) {
+      auto ts = LockStats::Clock::now();
+      size_t stalled = 0;
+      while (serving != ticket) {
+        uint32_t distance = ticket - serving;
+        if (stalled < kStallRounds) {
+          for (uint32_t i = 0; i < distance * kSpinsPerWaiter; ++i) {
+            CpuRelax();
+          }
+        } else {
+          std::this_thread::yield();
+        }
+        uint32_t last = serving;
+        serving = serving_.load(std::memory_order_acquire);
+        stalled = serving == last ? stalled + 1 : 0;
+      }
+      stats_.Waited(ts);
+    }
+    stats_.Acquired();
+  }
+
+  bool try_lock() {
+    uint32_t serving = serving_.load(std::memory_order_relaxed);
+    uint32_t ticket = serving;
+    if (!next_.compare_exchange_strong(ticket, serving + 1,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+      return false;
+    }
+    stats_.Acquired();
+    return true;
+  }
+
+  void unlock() {
+    serving_.store(serving_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+  }
+
+  const LockStats &GetStats() const { return stats_; }
+
+ private:
+  static constexpr uint32_t kSpinsPerWaiter = 64;
+  // Rounds without a release before a waiter yields.
+  static constexpr size_t kStallRounds = 1;
+
+  alignas(kCacheLineSize) std::atomic_uint32_t next_ = 0;
+  alignas(kCacheLineSize) std::atomic_uint32_t serving_ = 0;
+  LockStats stats_;
+};
+
+// MCS queue lock (Mellor-Crummey and Scott, 1991): every waiter spins on
+// its own node, so a release touches one remote cache line and the lock is
+// granted in FIFO order.
+//
+// Nodes come from a per-thread stack, so a thread may hold several MCS
+// locks as long as it releases them in reverse order, which is the case
+// for scoped locks and condition variable waits.
+class McsLock {
+ public:
+  void lock() {
+    Node *node = PushNode();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->locked.store(true, std::memory_order_relaxed);
+
+    Node *prev = tail_.exchange(node, std::memory_order_acq_rel);
+    if (prev != nullptr) {
+      auto ts = LockStats::Clock::now();
+      prev->next.store(node, std::memory_order_release);
+      Backoff backoff(kFifoMaxSpins);
+      while (node->locked.load(std::memory_order_acquire)) {
+        backoff.Pause();
+      }
+      stats_.Waited(ts);
+    }
+    stats_.Acquired();
+  }
+
+  bool try_lock() {
+    Node *node = PushNode();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *expected = nullptr;
+    if (!tail_.compare_exchange_strong(expected, node,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+      PopNode();
+      return false;
+    }
+    stats_.Acquired();
+    return true;
+  }
+
+  void unlock() {
+    Node *node = PopNode();
+    Node *next = node->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      Node *expected = node;
+      if (tail_.compare_exchange_strong(expected, nullptr,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+        return;
+      }
+      // A successor has swapped the tail but not linked itself yet.
+      Backoff backoff;
+      while ((next = node->next.load(std::memory_order_acquire)) == nullptr) {
+        backoff.Pause();
+      }
+    }
+    next->locked.store(false, std::memory_order_release);
+  }
+
+  const LockStats &GetStats() const { return stats_; }
+
+ private:
+  struct alignas(kCacheLineSize) Node {
+    std::atomic<Node *> next;
+    std::atomic_bool locked;
+  };
+
+  static constexpr size_t kMaxHeld = 8;
+
+  struct NodeStack {
+    Node nodes[kMaxHeld];
+    size_t depth = 0;
+  };
+
+  static NodeStack &ThreadNodes() {
+    static thread_local NodeStack stack;
+    return stack;
+  }
+
+  static Node *PushNode() {
+    NodeStack &stack = ThreadNodes();
+    assert(stack.depth < kMaxHeld && "too many MCS locks held");
+    return &stack.nodes[stack.depth++];
+  }
+
+  static Node *PopNode() {
+    NodeStack &stack = ThreadNodes();
+    assert(stack.depth > 0);
+    return &stack.nodes[--stack.depth];
+  }
+
+  alignas(kCacheLineSize) std::atomic<Node *> tail_ = nullptr;
+  LockStats stats_;
+};
+
+// Spins for a while and then sleeps in the kernel (futex on Linux, through
+// std::atomic::wait). The state is 0 = free, 1 = locked, 2 = locked with
+// sleepers (Drepper, "Futexes Are Tricky"), so unlock only makes a system
+// call when somebody may sleep.
+class SpinFutexLock {
+ public:
+  void lock() {
+    int state = kFree;
+    if (!state_.compare_exchange_strong(state, kLocked,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      auto ts = LockStats::Clock::now();
+      LockSlow();
+      stats_.Waited(ts);
+    }
+    stats_.Acquired();
+  }
+
+  bool try_lock() {
+    int state = kFree;
+    if (!state_.compare_exchange_strong(state, kLocked,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      return false;
+    }
+    stats_.Acquired();
+    return true;
+  }
+
+  void unlock() {
+    if (state_.exchange(kFree, std::memory_order_release) == kSleepers) {
+      state_.notify_one();
+    }
+  }
+
+  const LockStats &GetStats() const { return stats_; }
+
+ private:
+  static constexpr int kFree = 0;
+  static constexpr int kLocked = 1;
+  static constexpr int kSleepers = 2;
+  static constexpr size_t kSpins = 128;
+
+  std::atomic_int state_ = kFree;
+  LockStats stats_;
+
+  void LockSlow() {
+    for (size_t i = 0; i < kSpins; ++i) {
+      int state = kFree;
+      if (state_.load(std::memory_order_relaxed) == kFree &&
+          state_.compare_exchange_weak(state, kLocked,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      CpuRelax();
+    }
+    // From here on we may sleep, so take the lock in the sleepers state to
+    // make sure the owner wakes the next waiter.
+    while (state_.exchange(kSleepers, std::memory_order_acquire) != kFree) {
+      state_.wait(kSleepers, std::memory_order_relaxed);
+    }
+  }
+};
+
+// std::condition_variable only works with std::mutex.
+template <typename Lock>
+using ConditionVariableFor =
+    std::conditional_t<std::is_same_v<Lock, std::mutex>,
+                       std::condition_variable, std::condition_variable_any>;
+
+}  // namespace locks
+
+#endif  // LOCK_LOCK_POLICIES_H
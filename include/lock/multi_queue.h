@@ -0,0 +1,241 @@
+#ifndef LOCK_MULTI_QUEUE_H
+#define LOCK_MULTI_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "cache_line.h"
+#include "lock/lock_policies.h"
+
+namespace locks {
+
+// Relaxed FIFO queue (MultiQueue, Rihani, Sanders and Dementiev, 2015):
+// c * P sub-queues, each a FIFO under its own lock. Enqueue stamps the
+// element with the current time and appends it to a random sub-queue.
+// Dequeue samples two sub-queues and pops the one with the older head
+// ("power of two choices"); locks are only tried, a busy sub-queue is
+// replaced by another random one instead of waited for.
+//
+// Ordering is approximate: with n = c * P sub-queues the expected rank of
+// a dequeued element, i.e. the number of older elements still queued, is
+// O(n) and O(n log n) with high probability (Alistarh et al., "The power
+// of choice in priority scheduling", 2017). Elements enqueued by one
+// thread may therefore run out of order, but none is starved.
+//
+// TryDequeue returns false only after a full pass has seen every
+// sub-queue empty, so the blocking Dequeue can rely on it.
+template <typename T, typename Lock = std::mutex>
+class MultiQueue {
+ public:
+  typedef T value_type;
+
+  // tnum is the expected number of threads, P above; 0 means the number of
+  // hardware threads.
+  MultiQueue(size_t tnum = 0, size_t queues_per_thread = 2)
+      : queues_num_(std::max<size_t>(
+            1, queues_per_thread *
+                   (tnum != 0 ? tnum : std::thread::hardware_concurrency()))),
+        queues_(new SubQueue[queues_num_]),
+        need_stop_(false),
+        waiters_(0) {}
+
+  MultiQueue(const MultiQueue&) = delete;
+
+  // Sub-queues need no per-thread state, these keep the lock-free queue
+  // interface.
+  void RegisterThread() {}
+  void UnregisterThread() {}
+
+  size_t GetQueuesNumber() const { return queues_num_; }
+
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  // The element is constructed in the sub-queue, under its lock.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    if (need_stop_) {
+      return false;
+    }
+
+    uint64_t stamp = Now();
+    for (size_t attempt = 0;; ++attempt) {
+      SubQueue& queue = queues_[Random()];
+      std::unique_lock<Lock> lock(queue.lock, std::defer_lock);
+      if (attempt < kAttempts) {
+        if (!lock.try_lock()) {
+          continue;
+        }
+      } else {
+        lock.lock();
+      }
+
+      queue.items.emplace_back(std::piecewise_construct,
+                               std::forward_as_tuple(stamp),
+                               std::forward_as_tuple(
+                                   std::forward<Args>(args)...));
+      if (queue.items.size() == 1) {
+        queue.head_stamp.store(stamp);
+      }
+      break;
+    }
+    NotifyConsumer();
+
+    return true;
+  }
+
+  bool TryDequeue(T& data) {
+    for (size_t attempt = 0; attempt < kAttempts; ++attempt) {
+      SubQueue& first = queues_[Random()];
+      SubQueue& second = queues_[Random()];
+      SubQueue& queue =
+          first.head_stamp.load(std::memory_order_relaxed) <=
+                  second.head_stamp.load(std::memory_order_relaxed)
+              ? first
+              : second;
+      if (queue.head_stamp.load(std::memory_order_relaxed) == kEmpty) {
+        continue;
+      }
+      std::unique_lock<Lock> lock(queue.lock, std::try_to_lock);
+      if (lock.owns_lock() && Pop(queue, data)) {
+        return true;
+      }
+    }
+
+    // Sampling found nothing, fall back to a pass over all sub-queues.
+    size_t start = Random();
+    for (size_t i = 0; i < queues_num_; ++i) {
+      SubQueue& queue = queues_[(start + i) % queues_num_];
+      if (queue.head_stamp.load() == kEmpty) {
+        continue;
+      }
+      std::unique_lock<Lock> lock(queue.lock);
+      if (Pop(queue, data)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Blocks until an element is available, returns false if the queue is
+  // stopped and empty.
+  bool Dequeue(T& data) {
+    if (TryDequeue(data)) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(wait_lock_);
+    waiters_.fetch_add(1);
+    bool res;
+    not_empty_condition_.wait(lock, [this, &data, &res] {
+      res = TryDequeue(data);
+      return res || need_stop_;
+    });
+    waiters_.fetch_sub(1);
+    return res;
+  }
+
+  // Returns false on timeout or if the queue is stopped and empty.
+  template <typename Rep, typename Period>
+  bool DequeueFor(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+    if (TryDequeue(data)) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(wait_lock_);
+    waiters_.fetch_add(1);
+    bool res = false;
+    not_empty_condition_.wait_for(lock, timeout, [this, &data, &res] {
+      res = TryDequeue(data);
+      return res || need_stop_;
+    });
+    waiters_.fetch_sub(1);
+    return res;
+  }
+
+  // Summed over the sub-queue locks.
+  LockStatsTotal GetLockStats() const
+    requires requires(const Lock& lock) { lock.GetStats(); }
+  {
+    LockStatsTotal total;
+    for (size_t i = 0; i < queues_num_; ++i) {
+      total.Add(queues_[i].lock.GetStats());
+    }
+    return total;
+  }
+
+  void Stop() {
+    {
+      std::unique_lock<std::mutex> lock(wait_lock_);
+      need_stop_ = true;
+    }
+    not_empty_condition_.notify_all();
+  }
+
+ private:
+  static constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t kAttempts = 4;
+
+  struct alignas(kCacheLineSize) SubQueue {
+    // Stamp of the first element, kEmpty if there is none. Written under
+    // the lock, read without it to pick a sub-queue.
+    std::atomic_uint64_t head_stamp = kEmpty;
+    Lock lock;
+    std::deque<std::pair<uint64_t, T>> items;
+  };
+
+  const size_t queues_num_;
+  std::unique_ptr<SubQueue[]> queues_;
+
+  alignas(kCacheLineSize) std::atomic_bool need_stop_;
+  std::atomic_size_t waiters_;
+  std::mutex wait_lock_;
+  std::condition_variable not_empty_condition_;
+
+  static uint64_t Now() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+
+  size_t Random() {
+    static thread_local std::minstd_rand engine(
+        std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return engine() % queues_num_;
+  }
+
+  bool Pop(SubQueue& queue, T& data) {
+    if (queue.items.empty()) {
+      return false;
+    }
+    data = std::move(queue.items.front().second);
+    queue.items.pop_front();
+    queue.head_stamp.store(queue.items.empty() ? kEmpty
+                                               : queue.items.front().first);
+    return true;
+  }
+
+  // The seq_cst head_stamp store in Enqueue and the waiters_ load pair with
+  // the waiters_ increment and the head_stamp loads of the final pass in
+  // TryDequeue: either the sleeping consumer sees the element or we see the
+  // consumer. It holds wait_lock_ until it waits, so taking the lock makes
+  // sure the notification is not lost.
+  void NotifyConsumer() {
+    if (waiters_.load() == 0) {
+      return;
+    }
+    { std::unique_lock<std::mutex> lock(wait_lock_); }
+    not_empty_condition_.notify_one();
+  }
+};
+
+}  // namespace locks
+
+#endif  // LOCK_MULTI_QUEUE_H
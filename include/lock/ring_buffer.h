@@ -1,120 +1,223 @@
 #ifndef LOCK_RING_BUFFER_H
 #define LOCK_RING_BUFFER_H
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
 #include <condition_variable>
-#include <vector>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "lock/lock_policies.h"
 
 namespace locks {
 
+// Slots of a RingBuffer, raw storage where elements are constructed and
+// destroyed in place. N != 0 keeps them inline, N == 0 allocates them for
+// a capacity given at run time, rounded up to a power of two so that both
+// variants index with a mask instead of a divide.
+template <typename T, size_t N>
+struct RingSlots {
+  static_assert(std::has_single_bit(N), "N must be a power of two");
+
+  explicit RingSlots(size_t) {}
+  static constexpr size_t Capacity() { return N; }
+  static constexpr size_t Mask() { return N - 1; }
+  T *Slot(size_t idx) {
+    return std::launder(reinterpret_cast<T *>(storage) + (idx & (N - 1)));
+  }
+
+  alignas(T) std::byte storage[sizeof(T) * N];
+};
+
 template <typename T>
+struct RingSlots<T, 0> {
+  explicit RingSlots(size_t capacity)
+      : storage(new Storage[std::bit_ceil(std::max<size_t>(capacity, 1))]),
+        capacity_(capacity),
+        mask_(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1) {}
+  size_t Capacity() const { return capacity_; }
+  size_t Mask() const { return mask_; }
+  T *Slot(size_t idx) {
+    return std::launder(reinterpret_cast<T *>(&storage[idx & mask_]));
+  }
+
+  struct Storage {
+    alignas(T) std::byte bytes[sizeof(T)];
+  };
+  std::unique_ptr<Storage[]> storage;
+  size_t capacity_;
+  size_t mask_;
+};
+
+// Sequential ring of N elements, or of a capacity given to the constructor
+// when N is 0. head_ and tail_ are free-running counts of dequeued and
+// enqueued elements, so Full/Empty need no extra flag.
+//
+// Besides Enqueue/Dequeue, slots can be used in place: ClaimWrite
+// constructs the next element in its slot and returns it (null if the ring
+// is full), Commit makes it visible; ClaimRead returns the first element
+// (null if empty), Release destroys it and frees the slot.
+template <typename T, size_t N = 0>
 class RingBuffer {
  public:
-  RingBuffer(size_t buff_size) : head_idx_(0), tail_idx_(0), is_empty_(true) {
-    buffer_.resize(buff_size);
+  explicit RingBuffer(size_t buff_size = N)
+      : slots_(buff_size), head_(0), tail_(0) {}
+
+  RingBuffer(const RingBuffer&) = delete;
+
+  ~RingBuffer() {
+    while (!Empty()) {
+      slots_.Slot(head_++)->~T();
+    }
   }
 
-  bool Empty() const { return is_empty_; }
+  bool Empty() const { return head_ == tail_; }
 
-  bool Full() const { return (tail_idx_ + 1) % buffer_.size() == head_idx_; }
+  bool Full() const { return tail_ - head_ == slots_.Capacity(); }
 
-  size_t GetHeadIdx() const { return head_idx_; }
-  size_t GetTailIdx() const { return tail_idx_; }
+  // Slots of the first and the last element.
+  size_t GetHeadIdx() const { return head_ & slots_.Mask(); }
+  size_t GetTailIdx() const { return (tail_ - 1) & slots_.Mask(); }
 
-  bool Enqueue(T&& data) {
-    if (Full()) {
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    if (ClaimWrite(std::forward<Args>(args)...) == nullptr) {
       return false;
     }
-    if (is_empty_) {
-      head_idx_ = 0;
-      tail_idx_ = 0;
-      is_empty_ = false;
-    } else {
-      tail_idx_ = (tail_idx_ + 1) % buffer_.size();
-    }
-    buffer_[tail_idx_] = std::move(data);
-
+    Commit();
     return true;
   }
 
   bool Dequeue(T& data) {
-    if (Empty()) {
+    T *slot = ClaimRead();
+    if (slot == nullptr) {
       return false;
     }
-    data = std::move(buffer_[head_idx_]);
-    if (head_idx_ == tail_idx_) {
-      // last element
-      is_empty_ = true;
-    } else {
-      head_idx_ = (head_idx_ + 1) % buffer_.size();
-    }
+    data = std::move(*slot);
+    Release();
     return true;
   }
 
- private:
-  std::atomic_size_t head_idx_;
-  std::atomic_size_t tail_idx_;
-  std::atomic_bool is_empty_;
+  template <typename... Args>
+  T *ClaimWrite(Args&&... args) {
+    if (Full()) {
+      return nullptr;
+    }
+    return new (slots_.Slot(tail_)) T(std::forward<Args>(args)...);
+  }
+
+  void Commit() { ++tail_; }
+
+  T *ClaimRead() { return Empty() ? nullptr : slots_.Slot(head_); }
 
-  std::vector<T> buffer_;
+  void Release() { slots_.Slot(head_++)->~T(); }
+
+ private:
+  RingSlots<T, N> slots_;
+  size_t head_;
+  size_t tail_;
 };
 
-template <typename T>
+// Lock is std::mutex or one of the policies from lock_policies.h.
+template <typename T, typename Lock = std::mutex, size_t N = 0>
 class RingBufferThreadSafe {
  public:
-  RingBufferThreadSafe(size_t buff_size)
-      : buffer_(buff_size), need_stop_(false) {}
+  explicit RingBufferThreadSafe(size_t buff_size = N)
+      : buffer_(buff_size),
+        need_stop_(false),
+        not_full_waiters_(0),
+        not_empty_waiters_(0) {}
 
   ~RingBufferThreadSafe() {}
 
-  bool Enqueue(T&& data) {
-    std::unique_lock<std::mutex> lock(buff_lock_);
-    buff_is_not_full_condition_.wait(lock, [this] {
-      return std::forward<bool>(need_stop_) || !buffer_.Full();
-    });
-    if (need_stop_) {
-      return false;
+  // The other side is only notified when some of its threads sleep, and
+  // after the unlock so that the woken thread does not block on buff_lock_.
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  // The element is constructed in its slot, under the lock.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    bool notify;
+    {
+      std::unique_lock<Lock> lock(buff_lock_);
+      if (!need_stop_ && buffer_.Full()) {
+        ++not_full_waiters_;
+        buff_is_not_full_condition_.wait(lock, [this] {
+          return std::forward<bool>(need_stop_) || !buffer_.Full();
+        });
+        --not_full_waiters_;
+      }
+      if (need_stop_) {
+        return false;
+      }
+
+      bool res = buffer_.Emplace(std::forward<Args>(args)...);
+      assert(res);
+      notify = not_empty_waiters_ > 0;
     }
 
-    bool res = buffer_.Enqueue(std::move(data));
-    assert(res);
-
-    buff_is_not_empty_condition_.notify_one();
+    if (notify) {
+      buff_is_not_empty_condition_.notify_one();
+    }
 
-    return res;
+    return true;
   }
 
   bool Dequeue(T& data) {
-    std::unique_lock<std::mutex> lock(buff_lock_);
-    buff_is_not_empty_condition_.wait(lock, [this] {
-      return std::forward<bool>(need_stop_) || !buffer_.Empty();
-    });
-    if (need_stop_ && buffer_.Empty()) {
-      return false;
+    bool notify;
+    {
+      std::unique_lock<Lock> lock(buff_lock_);
+      if (!need_stop_ && buffer_.Empty()) {
+        ++not_empty_waiters_;
+        buff_is_not_empty_condition_.wait(lock, [this] {
+          return std::forward<bool>(need_stop_) || !buffer_.Empty();
+        });
+        --not_empty_waiters_;
+      }
+      if (need_stop_ && buffer_.Empty()) {
+        return false;
+      }
+
+      bool res = buffer_.Dequeue(data);
+      assert(res);
+      notify = not_full_waiters_ > 0;
     }
 
-    bool res = buffer_.Dequeue(data);
-    assert(res);
-
-    buff_is_not_full_condition_.notify_one();
+    if (notify) {
+      buff_is_not_full_condition_.notify_one();
+    }
 
-    return res;
+    return true;
   }
 
+  const Lock &GetLock() const { return buff_lock_; }
+
   void Stop() {
-    need_stop_ = true;
+    {
+      std::unique_lock<Lock> lock(buff_lock_);
+      need_stop_ = true;
+    }
     buff_is_not_empty_condition_.notify_all();
     buff_is_not_full_condition_.notify_all();
   }
 
  private:
-  RingBuffer<T> buffer_;
+  RingBuffer<T, N> buffer_;
 
   std::atomic_bool need_stop_;
-  std::mutex buff_lock_;
-  std::condition_variable buff_is_not_full_condition_;
-  std::condition_variable buff_is_not_empty_condition_;
+  // Guarded by buff_lock_.
+  size_t not_full_waiters_;
+  size_t not_empty_waiters_;
+  Lock buff_lock_;
+  ConditionVariableFor<Lock> buff_is_not_full_condition_;
+  ConditionVariableFor<Lock> buff_is_not_empty_condition_;
 };
 
 }  // namespace locks
@@ -0,0 +1,179 @@
+#ifndef LOCK_TWO_LOCK_QUEUE_H
+#define LOCK_TWO_LOCK_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#include "cache_line.h"
+#include "lock/lock_policies.h"
+
+namespace locks {
+
+// Linked queue with separate head and tail locks (Michael and Scott, 1996):
+// a dummy node keeps producers and consumers on different nodes, so they
+// only contend among themselves. Consumers count themselves in waiters_
+// before sleeping and producers skip the notification when nobody sleeps.
+//
+// T must be default constructible, the dummy node holds an empty value.
+// Lock is std::mutex or one of the policies from lock_policies.h.
+template <typename T, typename Lock = std::mutex>
+class TwoLockQueue {
+ public:
+  typedef T value_type;
+
+  TwoLockQueue() : need_stop_(false), waiters_(0) {
+    head_ = new Node;
+    tail_ = head_;
+  }
+
+  TwoLockQueue(const TwoLockQueue&) = delete;
+
+  ~TwoLockQueue() {
+    while (head_ != nullptr) {
+      Node* next = head_->next.load(std::memory_order_relaxed);
+      delete head_;
+      head_ = next;
+    }
+  }
+
+  bool Enqueue(T&& data) { return Emplace(std::move(data)); }
+
+  // The element is constructed in its node before tail_lock_ is taken.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    if (need_stop_) {
+      return false;
+    }
+
+    Node* node = new Node(std::in_place, std::forward<Args>(args)...);
+    {
+      std::unique_lock<Lock> lock(tail_lock_);
+      tail_->next.store(node);
+      tail_ = node;
+    }
+    NotifyConsumer();
+
+    return true;
+  }
+
+  // Blocks until an element is available, returns false if the queue is
+  // stopped and empty.
+  bool Dequeue(T& data) {
+    Node* old;
+    {
+      std::unique_lock<Lock> lock(head_lock_);
+      if (Empty() && !need_stop_) {
+        waiters_.fetch_add(1);
+        not_empty_condition_.wait(lock,
+                                  [this] { return need_stop_ || !Empty(); });
+        waiters_.fetch_sub(1);
+      }
+      old = Pop(data);
+    }
+    delete old;
+    return old != nullptr;
+  }
+
+  bool TryDequeue(T& data) {
+    Node* old;
+    {
+      std::unique_lock<Lock> lock(head_lock_);
+      old = Pop(data);
+    }
+    delete old;
+    return old != nullptr;
+  }
+
+  // Returns false on timeout or if the queue is stopped and empty.
+  template <typename Rep, typename Period>
+  bool DequeueFor(T& data, const std::chrono::duration<Rep, Period>& timeout) {
+    Node* old;
+    {
+      std::unique_lock<Lock> lock(head_lock_);
+      if (Empty() && !need_stop_) {
+        waiters_.fetch_add(1);
+        not_empty_condition_.wait_for(
+            lock, timeout, [this] { return need_stop_ || !Empty(); });
+        waiters_.fetch_sub(1);
+      }
+      old = Pop(data);
+    }
+    delete old;
+    return old != nullptr;
+  }
+
+  const Lock &GetHeadLock() const { return head_lock_; }
+  const Lock &GetTailLock() const { return tail_lock_; }
+
+  LockStatsTotal GetLockStats() const
+    requires requires(const Lock& lock) { lock.GetStats(); }
+  {
+    LockStatsTotal total;
+    total.Add(head_lock_.GetStats());
+    total.Add(tail_lock_.GetStats());
+    return total;
+  }
+
+  void Stop() {
+    {
+      std::unique_lock<Lock> lock(head_lock_);
+      need_stop_ = true;
+    }
+    not_empty_condition_.notify_all();
+  }
+
+ private:
+  struct Node {
+    Node() : next(nullptr) {}
+    template <typename... Args>
+    explicit Node(std::in_place_t, Args&&... args)
+        : data(std::forward<Args>(args)...), next(nullptr) {}
+    T data;
+    std::atomic<Node*> next;
+  };
+
+  // Written under tail_lock_, read under head_lock_.
+  bool Empty() const { return head_->next.load() == nullptr; }
+
+  // Moves the first element out and makes its node the new dummy. Returns
+  // the old dummy for deletion outside the lock, nullptr if empty.
+  Node* Pop(T& data) {
+    Node* next = head_->next.load();
+    if (next == nullptr) {
+      return nullptr;
+    }
+    data = std::move(next->data);
+    Node* old = head_;
+    head_ = next;
+    return old;
+  }
+
+  // The seq_cst store of tail_->next and the waiters_ load pair with the
+  // waiters_ increment and the Empty() check of a consumer: either the
+  // consumer sees the node or we see the consumer. Taking head_lock_ then
+  // guarantees it is already waiting, so the notification is not lost and
+  // can be issued after the unlock.
+  void NotifyConsumer() {
+    if (waiters_.load() == 0) {
+      return;
+    }
+    { std::unique_lock<Lock> lock(head_lock_); }
+    not_empty_condition_.notify_one();
+  }
+
+  alignas(kCacheLineSize) Node* head_;
+  Lock head_lock_;
+  ConditionVariableFor<Lock> not_empty_condition_;
+  std::atomic_bool need_stop_;
+  std::atomic_size_t waiters_;
+
+  alignas(kCacheLineSize) Node* tail_;
+  Lock tail_lock_;
+};
+
+}  // namespace locks
+
+#endif  // LOCK_TWO_LOCK_QUEUE_H
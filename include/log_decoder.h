@@ -0,0 +1,137 @@
+#ifndef LOG_DECODER_H
+#define LOG_DECODER_H
+
+#include <algorithm>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "binary_log.h"
+#include "log_format.h"
+
+// Converts a binary log (see binary_log.h) back to the text layout of the
+// logger. A scan cuts the log into blocks of records, the records of a
+// block are formatted by `threads` threads at once and written out in
+// order.
+class LogDecoder {
+ public:
+  static constexpr size_t kBlockRecords = 1 << 16;  // per thread
+
+  LogDecoder(const LogPattern &pattern, std::ostream &out, size_t threads,
+             size_t block_records = kBlockRecords)
+      : pattern_(pattern), out_(out), threads_(threads), outputs_(threads) {
+    block_.reserve(block_records * threads_);
+  }
+
+  // Returns false if the log is malformed; the records before the first
+  // malformed entry are written out all the same.
+  bool Decode(const char *data, size_t size) {
+    BinaryLogReader reader(data, size);
+    BinaryLogReader::Entry entry;
+    while (reader.Next(entry)) {
+      switch (entry.kind) {
+        case BinaryLogReader::Entry::kSegment:
+          segment_sites_.clear();
+          break;
+        case BinaryLogReader::Entry::kSite:
+          if (entry.site_id != segment_sites_.size()) {
+            Flush();
+            return false;
+          }
+          sites_.push_back(entry.site);
+          segment_sites_.push_back(&sites_.back());
+          break;
+        case BinaryLogReader::Entry::kRecord:
+          if (entry.site_id >= segment_sites_.size()) {
+            Flush();
+            return false;
+          }
+          block_.push_back(
+              {entry.time, segment_sites_[entry.site_id], entry.args});
+          if (block_.size() == block_.capacity()) {
+            Flush();
+          }
+          break;
+      }
+    }
+    Flush();
+    return !reader.Failed();
+  }
+
+  // Records written out.
+  size_t GetRecords() const { return records_; }
+  // Records written out with malformed arguments.
+  size_t GetMalformed() const { return malformed_; }
+
+ private:
+  struct Record {
+    time_t time;
+    const BinaryLogReader::Site *site;
+    std::string_view args;
+  };
+
+  const LogPattern &pattern_;
+  std::ostream &out_;
+  size_t threads_;
+  std::vector<std::string> outputs_;
+  std::deque<BinaryLogReader::Site> sites_;
+  std::vector<const BinaryLogReader::Site *> segment_sites_;
+  std::vector<Record> block_;
+  size_t records_ = 0;
+  size_t malformed_ = 0;
+
+  // Formats records into out, returns the number of malformed ones.
+  static size_t FormatRecords(const LogPattern &pattern, const Record *begin,
+                              const Record *end, std::string &out) {
+    LogTimeFormatter time_formatter;
+    size_t malformed = 0;
+    out.clear();
+    for (const Record *record = begin; record != end; ++record) {
+      const BinaryLogReader::Site &site = *record->site;
+      LogRecordView view = {record->time, site.level,  site.file,
+                            site.line,    site.format, record->args};
+      bool ok = true;
+      size_t size = out.size();
+      out.resize_and_overwrite(
+          size + pattern.MaxSize(view), [&](char *buf, size_t) {
+            return pattern.Format(time_formatter, view, buf + size, ok) - buf;
+          });
+      if (!ok) {
+        ++malformed;
+      }
+    }
+    return malformed;
+  }
+
+  void Flush() {
+    size_t chunks = std::min(threads_, block_.size());
+    std::vector<size_t> malformed(chunks);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < chunks; ++i) {
+      const Record *begin = block_.data() + block_.size() * i / chunks;
+      const Record *end = block_.data() + block_.size() * (i + 1) / chunks;
+      if (i + 1 == chunks) {
+        malformed[i] = FormatRecords(pattern_, begin, end, outputs_[i]);
+      } else {
+        workers.emplace_back([&, begin, end, i] {
+          malformed[i] = FormatRecords(pattern_, begin, end, outputs_[i]);
+        });
+      }
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    for (size_t i = 0; i < chunks; ++i) {
+      out_.write(outputs_[i].data(), outputs_[i].size());
+      malformed_ += malformed[i];
+    }
+    records_ += block_.size();
+    block_.clear();
+  }
+};
+
+#endif  // LOG_DECODER_H
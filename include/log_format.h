@@ -0,0 +1,338 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "log_level.h"
+
+// Layout of the log files.
+enum class LogFormat {
+  kText,   // one formatted line per record
+  kBinary  // encoded records, see binary_log.h and log-decode
+};
+
+inline const char *LogFormatName(LogFormat format) {
+  switch (format) {
+    case LogFormat::kText:
+      return "text";
+    case LogFormat::kBinary:
+      return "binary";
+  }
+  return "unknown";
+}
+
+// Returns false if `name` is not a known format.
+inline bool ParseLogFormat(const std::string &name, LogFormat &format) {
+  for (LogFormat f : {LogFormat::kText, LogFormat::kBinary}) {
+    if (name == LogFormatName(f)) {
+      format = f;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void PutVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+inline bool GetVarint(const char *&pos, const char *end, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; pos != end && shift < 64; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*pos++);
+    value |= uint64_t(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline uint64_t ZigZag(int64_t value) {
+  return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t value) {
+  return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+// The arguments of a log message are kept encoded until the record is
+// written, so a task only copies them: every argument is a type byte
+// followed by a varint (zigzag for signed integers), the 8 bytes of a
+// double in host order or a varint size and the bytes of a string. The
+// binary log stores them as is.
+enum class LogArgType : uint8_t { kInt, kUInt, kDouble, kString };
+
+template <typename T>
+void AppendLogArg(std::string &args, const T &value) {
+  if constexpr (std::is_same_v<T, char>) {
+    AppendLogArg(args, std::string_view(&value, 1));
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    args.push_back(static_cast<char>(LogArgType::kInt));
+    PutVarint(args, ZigZag(value));
+  } else if constexpr (std::is_integral_v<T>) {
+    args.push_back(static_cast<char>(LogArgType::kUInt));
+    PutVarint(args, value);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    double d = value;
+    args.push_back(static_cast<char>(LogArgType::kDouble));
+    args.append(reinterpret_cast<const char *>(&d), sizeof(d));
+  } else {
+    static_assert(std::is_convertible_v<const T &, std::string_view>,
+                  "Log arguments are numbers and strings");
+    std::string_view s(value);
+    args.push_back(static_cast<char>(LogArgType::kString));
+    PutVarint(args, s.size());
+    args.append(s);
+  }
+}
+
+// Writes the next encoded argument of args (advanced past it) to out
+// (advanced past the text): integers in decimal, doubles in the shortest
+// form that reads back to the same value, strings as they are. Nothing
+// depends on the locale. An argument takes at most 3 times its encoded
+// size. Returns false if args is malformed.
+inline bool FormatLogArg(std::string_view &args, char *&out) {
+  if (args.empty()) {
+    return false;
+  }
+  const char *pos = args.data() + 1;
+  const char *end = args.data() + args.size();
+  uint64_t value;
+  switch (static_cast<LogArgType>(args[0])) {
+    case LogArgType::kInt:
+      if (!GetVarint(pos, end, value)) {
+        return false;
+      }
+      out = std::to_chars(out, out + 24, UnZigZag(value)).ptr;
+      break;
+    case LogArgType::kUInt:
+      if (!GetVarint(pos, end, value)) {
+        return false;
+      }
+      out = std::to_chars(out, out + 24, value).ptr;
+      break;
+    case LogArgType::kDouble: {
+      double d;
+      if (end - pos < static_cast<ptrdiff_t>(sizeof(d))) {
+        return false;
+      }
+      std::memcpy(&d, pos, sizeof(d));
+      pos += sizeof(d);
+      out = std::to_chars(out, out + 27, d).ptr;
+      break;
+    }
+    case LogArgType::kString:
+      if (!GetVarint(pos, end, value) || uint64_t(end - pos) < value) {
+        return false;
+      }
+      std::memcpy(out, pos, value);
+      out += value;
+      pos += value;
+      break;
+    default:
+      return false;
+  }
+  args.remove_prefix(pos - args.data());
+  return true;
+}
+
+// Local time of a record, a formatter reformats only when the second
+// changes.
+class LogTimeFormatter {
+ public:
+  std::string_view Format(time_t time) {
+    if (time != time_ || size_ == 0) {
+      std::tm tm;
+      localtime_r(&time, &tm);
+      size_ = std::strftime(text_, sizeof(text_), "%Y-%m-%d %H:%M:%S", &tm);
+      time_ = time;
+    }
+    return std::string_view(text_, size_);
+  }
+
+ private:
+  time_t time_ = 0;
+  size_t size_ = 0;
+  char text_[32];
+};
+
+// What a text record is made of.
+struct LogRecordView {
+  time_t time;
+  LogLevel level;
+  std::string_view file;
+  int line;
+  std::string_view format;  // "{}" stands for the next argument
+  std::string_view args;    // encoded, see AppendLogArg
+};
+
+// Layout of the text records: %d is the time, %l the level, %f the file,
+// %n the line, %m the message and %% a percent sign. Every record ends with
+// a new line.
+constexpr char kDefaultLogPattern[] = "%d  %l %f:%n %m";
+
+// A layout compiled once into the list of its fields, so formatting a
+// record is a walk over the list writing straight into the output buffer.
+class LogPattern {
+ public:
+  // throw: std::invalid_argument on an unknown field
+  explicit LogPattern(std::string_view pattern = kDefaultLogPattern) {
+    std::string text;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      if (pattern[i] != '%') {
+        text.push_back(pattern[i]);
+        continue;
+      }
+      if (++i == pattern.size()) {
+        throw std::invalid_argument("Log pattern ends with %");
+      }
+      Field::Kind kind;
+      switch (pattern[i]) {
+        case '%':
+          text.push_back('%');
+          continue;
+        case 'd':
+          kind = Field::kTime;
+          break;
+        case 'l':
+          kind = Field::kLevel;
+          break;
+        case 'f':
+          kind = Field::kFile;
+          break;
+        case 'n':
+          kind = Field::kLine;
+          break;
+        case 'm':
+          kind = Field::kMessage;
+          break;
+        default:
+          throw std::invalid_argument(
+              std::string("Unknown log pattern field %") + pattern[i]);
+      }
+      if (!text.empty()) {
+        fields_.push_back({Field::kText, std::move(text)});
+        text.clear();
+      }
+      fields_.push_back({kind, {}});
+    }
+    text.push_back('\n');
+    fields_.push_back({Field::kText, std::move(text)});
+  }
+
+  // Bound of the size of a record.
+  size_t MaxSize(const LogRecordView &record) const {
+    size_t size = 0;
+    for (const Field &field : fields_) {
+      switch (field.kind) {
+        case Field::kText:
+          size += field.text.size();
+          break;
+        case Field::kTime:
+          size += 32;
+          break;
+        case Field::kLevel:
+          size += 8;
+          break;
+        case Field::kFile:
+          size += record.file.size();
+          break;
+        case Field::kLine:
+          size += 12;
+          break;
+        case Field::kMessage:
+          size += record.format.size() + 3 * record.args.size();
+          break;
+      }
+    }
+    return size;
+  }
+
+  // Writes the record to out, which has room for MaxSize(record) bytes,
+  // and returns the end of the text. If the arguments are malformed ok is
+  // cleared and the message is cut after the last good argument.
+  char *Format(LogTimeFormatter &time_formatter, const LogRecordView &record,
+               char *out, bool &ok) const {
+    for (const Field &field : fields_) {
+      switch (field.kind) {
+        case Field::kText:
+          out = Copy(field.text, out);
+          break;
+        case Field::kTime:
+          out = Copy(time_formatter.Format(record.time), out);
+          break;
+        case Field::kLevel:
+          out = Copy(LogLevelName(record.level), out);
+          break;
+        case Field::kFile:
+          out = Copy(record.file, out);
+          break;
+        case Field::kLine:
+          out = std::to_chars(out, out + 12, record.line).ptr;
+          break;
+        case Field::kMessage:
+          out = FormatMessage(record.format, record.args, out, ok);
+          break;
+      }
+    }
+    return out;
+  }
+
+  // Replaces the contents of out with the record, keeping its buffer.
+  // Returns false if the arguments are malformed.
+  bool Format(LogTimeFormatter &time_formatter, const LogRecordView &record,
+              std::string &out) const {
+    bool ok = true;
+    out.resize_and_overwrite(MaxSize(record), [&](char *buf, size_t) {
+      return Format(time_formatter, record, buf, ok) - buf;
+    });
+    return ok;
+  }
+
+ private:
+  struct Field {
+    enum Kind { kText, kTime, kLevel, kFile, kLine, kMessage } kind;
+    std::string text;  // kText
+  };
+
+  std::vector<Field> fields_;
+
+  static char *Copy(std::string_view s, char *out) {
+    std::memcpy(out, s.data(), s.size());
+    return out + s.size();
+  }
+
+  // Arguments left over are ignored.
+  static char *FormatMessage(std::string_view format, std::string_view args,
+                             char *out, bool &ok) {
+    while (!args.empty()) {
+      size_t field = format.find("{}");
+      if (field == std::string_view::npos) {
+        break;
+      }
+      out = Copy(format.substr(0, field), out);
+      format.remove_prefix(field + 2);
+      if (!FormatLogArg(args, out)) {
+        ok = false;
+        return out;
+      }
+    }
+    return Copy(format, out);
+  }
+};
+
+#endif  // LOG_FORMAT_H
@@ -0,0 +1,173 @@
+#ifndef LOG_LEVEL_H
+#define LOG_LEVEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class LogLevel { kTrace, kDebug, kInfo, kWarning, kError };
+
+inline const char *LogLevelName(LogLevel level) {
+  switch (level) {
+    case LogLevel::kTrace:
+      return "trace";
+    case LogLevel::kDebug:
+      return "debug";
+    case LogLevel::kInfo:
+      return "info";
+    case LogLevel::kWarning:
+      return "warning";
+    case LogLevel::kError:
+      return "error";
+  }
+  return "unknown";
+}
+
+// Returns false if `name` is not a known level.
+inline bool ParseLogLevel(const std::string &name, LogLevel &level) {
+  for (LogLevel l : {LogLevel::kTrace, LogLevel::kDebug, LogLevel::kInfo,
+                     LogLevel::kWarning, LogLevel::kError}) {
+    if (name == LogLevelName(l)) {
+      level = l;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Call sites below this level are compiled out, it is selected with the
+// LOG_MIN_LEVEL CMake option.
+#if defined(LOG_MIN_LEVEL_TRACE)
+constexpr LogLevel kLogMinLevel = LogLevel::kTrace;
+#elif defined(LOG_MIN_LEVEL_INFO)
+constexpr LogLevel kLogMinLevel = LogLevel::kInfo;
+#elif defined(LOG_MIN_LEVEL_WARNING)
+constexpr LogLevel kLogMinLevel = LogLevel::kWarning;
+#elif defined(LOG_MIN_LEVEL_ERROR)
+constexpr LogLevel kLogMinLevel = LogLevel::kError;
+#else   // LOG_MIN_LEVEL_DEBUG
+constexpr LogLevel kLogMinLevel = LogLevel::kDebug;
+#endif  // LOG_MIN_LEVEL_TRACE
+
+// A log statement. Sites are constant-initialized statics, so checking one
+// costs no guard: Enabled() is a relaxed load of a flag that already folds
+// in the runtime level and the per-site switch, and a single branch on it
+// when the site is off. A site registers with LogSites the first time it is
+// reached and from then on LogSites keeps its flag up to date.
+class LogSite {
+ public:
+  constexpr LogSite(LogLevel level, const char *file, int line,
+                    const char *format)
+      : level_(level),
+        file_(file),
+        line_(line),
+        format_(format),
+        state_(kUnregistered) {}
+
+  LogSite(const LogSite &) = delete;
+
+  bool Enabled() {
+    uint8_t state = state_.load(std::memory_order_relaxed);
+    return state != kOff && (state == kOn || Register());
+  }
+
+  LogLevel GetLevel() const { return level_; }
+  const char *GetFile() const { return file_; }
+  int GetLine() const { return line_; }
+  const char *GetFormat() const { return format_; }
+
+ private:
+  friend class LogSites;
+
+  enum : uint8_t { kOff, kOn, kUnregistered };
+
+  const LogLevel level_;
+  const char *const file_;
+  const int line_;
+  const char *const format_;
+  std::atomic_uint8_t state_;
+
+  bool Register();
+};
+
+// Runtime filter of the log sites: a minimum level and a list of disabled
+// sites. A site is named "file:line" and is disabled by any pattern that is
+// a suffix of its name or of its file, so "task_generator.cpp" turns off
+// every site of that file.
+class LogSites {
+ public:
+  static LogLevel GetLevel() {
+    std::unique_lock<std::mutex> lock(Get().lock);
+    return Get().level;
+  }
+
+  static void SetLevel(LogLevel level) {
+    Registry &registry = Get();
+    std::unique_lock<std::mutex> lock(registry.lock);
+    registry.level = level;
+    registry.Update();
+  }
+
+  static void SetSiteEnabled(const std::string &pattern, bool enabled) {
+    Registry &registry = Get();
+    std::unique_lock<std::mutex> lock(registry.lock);
+    auto &disabled = registry.disabled;
+    std::erase(disabled, pattern);
+    if (!enabled) {
+      disabled.push_back(pattern);
+    }
+    registry.Update();
+  }
+
+ private:
+  friend class LogSite;
+
+  struct Registry {
+    std::mutex lock;
+    LogLevel level = LogLevel::kInfo;
+    std::vector<std::string> disabled;
+    std::vector<LogSite *> sites;
+
+    bool IsEnabled(const LogSite &site) const {
+      if (site.level_ < level) {
+        return false;
+      }
+      std::string_view file(site.file_);
+      std::string name = std::string(file) + ":" + std::to_string(site.line_);
+      for (const std::string &pattern : disabled) {
+        if (name.ends_with(pattern) || file.ends_with(pattern)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void Update() {
+      for (LogSite *site : sites) {
+        site->state_.store(IsEnabled(*site) ? LogSite::kOn : LogSite::kOff,
+                           std::memory_order_relaxed);
+      }
+    }
+  };
+
+  static Registry &Get() {
+    static Registry registry;
+    return registry;
+  }
+};
+
+inline bool LogSite::Register() {
+  LogSites::Registry &registry = LogSites::Get();
+  std::unique_lock<std::mutex> lock(registry.lock);
+  if (state_.load(std::memory_order_relaxed) == kUnregistered) {
+    registry.sites.push_back(this);
+    state_.store(registry.IsEnabled(*this) ? kOn : kOff,
+                 std::memory_order_relaxed);
+  }
+  return state_.load(std::memory_order_relaxed) == kOn;
+}
+
+#endif  // LOG_LEVEL_H
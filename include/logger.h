@@ -4,28 +4,31 @@
 #include <chrono>
 #include <fstream>
 #include <memory>
-#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "log_format.h"
+#include "log_level.h"
+#include "message_pool.h"
 #include "queue_types.h"
 #include "runnable.h"
 
-struct LogMessage {
+// The arguments are kept encoded (see AppendLogArg), the record is only
+// formatted by the logger thread.
+struct LogMessage : public PooledMessage {
   time_t time;
-  std::string fname;
-  int line_num;
-  std::stringstream smsg;
+  const LogSite *site;
+  std::string args;
 
   void set_time() {
     auto now = std::chrono::system_clock::now();
     time = std::chrono::system_clock::to_time_t(now);
   }
-};
 
-template <typename T>
-LogMessage& operator<<(LogMessage& log_msg, const T& s) {
-  log_msg.smsg << s;
-  return log_msg;
-}
+  // Empties the message for reuse, keeping the arguments buffer.
+  void Reset() { args.clear(); }
+};
 
 class LogAppender {
  public:
@@ -33,34 +36,94 @@ class LogAppender {
   LogAppender(const LogAppender&) = delete;
   virtual ~LogAppender() {}
 
-  virtual bool Write(std::string msg) = 0;
+  // msg is only valid during the call.
+  virtual bool Write(std::string_view msg) = 0;
 };
 
 class FileLogAppender final : public LogAppender {
  public:
-  FileLogAppender(std::string file_path);
+  FileLogAppender(std::string file_path, bool append = false);
   ~FileLogAppender();
 
-  bool Write(std::string msg) override;
+  bool Write(std::string_view msg) override;
 
  private:
   std::ofstream log_file_;
 };
 
+// Drains the log queue on its own thread. With one appender the records
+// are written there; with several, the logger formats every record once
+// into a multicast ring and each appender reads the ring on its own thread
+// at its own pace, the slowest one holding back the logger.
 class Logger : public Runnable {
  public:
-  Logger(LoggerQueue &logger_queue, LogAppender* helper);
+  // throw: std::invalid_argument if pattern is not a valid LogPattern
+  Logger(LoggerQueue &logger_queue, LogAppender* helper,
+         LogFormat format = LogFormat::kText,
+         std::string_view pattern = kDefaultLogPattern);
+
+  // Must be called before Start().
+  void AddAppender(LogAppender* appender);
+
+  // A message from the calling thread's cache of the pool; the logger
+  // returns it there once written, so steady-state logging does not
+  // allocate.
+  std::unique_ptr<LogMessage> NewMessage() { return pool_.Acquire(); }
+
+  // Every thread adding messages registers first, see RegisterQueueThread.
+  void RegisterThread() { RegisterQueueThread(logger_queue_); }
+  void UnregisterThread() { UnregisterQueueThread(logger_queue_); }
 
   bool AddMessage(std::unique_ptr<LogMessage>&& msg);
 
+  // Adds a message of site with args, see LOG.
+  template <typename... Args>
+  bool Log(const LogSite &site, const Args &...args) {
+    std::unique_ptr<LogMessage> msg = NewMessage();
+    msg->set_time();
+    msg->site = &site;
+    (AppendLogArg(msg->args, args), ...);
+    return AddMessage(std::move(msg));
+  }
+
+  uint64_t GetAllocatedMessages() const { return pool_.GetAllocated(); }
+
   void Stop() override;
 
  private:
-  std::unique_ptr<LogAppender> appender_;
+  static constexpr size_t kFanOutCapacity = 1024;
+
+  std::vector<std::unique_ptr<LogAppender>> appenders_;
+
+  LogFormat format_;
+  LogPattern pattern_;
+
+  MessagePool<LogMessage> pool_;
 
   LoggerQueue &logger_queue_;
 
   void Run() override;
+
+  // Passes every queued message to write until the logger is stopped and
+  // the queue is empty.
+  template <typename Write>
+  void Drain(Write write);
 };
 
+// LOG(logger, kInfo, "a: {}, b: {}", a, b);
+//
+// Every "{}" of the format, a string literal, stands for the next argument.
+// Statements below kLogMinLevel are compiled out. The others take a message
+// only if their site is enabled, see LogSite.
+#define LOG(logger, level, format, ...)                                   \
+  do {                                                                    \
+    if constexpr (LogLevel::level >= kLogMinLevel) {                      \
+      static constinit LogSite log_site(LogLevel::level, __FILE__,        \
+                                        __LINE__, format);                \
+      if (log_site.Enabled()) {                                           \
+        (logger).Log(log_site __VA_OPT__(, ) __VA_ARGS__);                \
+      }                                                                   \
+    }                                                                     \
+  } while (0)
+
 #endif  // LOGGER_H
\ No newline at end of file
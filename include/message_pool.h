@@ -0,0 +1,166 @@
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "lock-free/mpsc_queue.h"
+
+// Base of the messages of a MessagePool. The MpscNode link is used by the
+// queue carrying the message to its consumer and then by the return queue.
+struct PooledMessage : public lock_free::MpscNode {
+  void *pool_cache = nullptr;  // the cache the message returns to
+};
+
+// Pool of messages that producer threads fill and hand to consumers, which
+// give them back once done with them (log messages going to the logger).
+//
+// Every producer thread gets a cache of its own: a free list only it
+// touches, and an MpscQueue through which consumers return the messages
+// that came from this cache. Acquire pops the free list and, once it is
+// empty, refills it from the return queue, so a message makes its round
+// trip without a heap allocation; new messages are only allocated while
+// the pool warms up. T::Reset() prepares a message for reuse and should
+// keep the buffers it owns.
+//
+// Caches live as long as the pool. When a thread exits its caches become
+// orphans, still taking the messages returned to them, and the next thread
+// that needs a cache adopts one: a pool fed by short-lived threads keeps
+// as many caches as it has threads at once. A thread drops its entries for
+// pools that have been destroyed when it looks up a new cache.
+template <typename T>
+class MessagePool {
+ public:
+  MessagePool()
+      : id_(next_id_.fetch_add(1)),
+        allocated_(0),
+        shared_(std::make_shared<Shared>()) {}
+
+  MessagePool(const MessagePool &) = delete;
+
+  // Messages still out are owned by whoever holds them. The caches go with
+  // the last of the pool and the threads exiting at the same time.
+  ~MessagePool() = default;
+
+  std::unique_ptr<T> Acquire() {
+    Cache *cache = ThreadCache();
+    if (cache->free.empty()) {
+      std::unique_ptr<T> msg;
+      while (cache->returned.TryDequeue(msg)) {
+        cache->free.push_back(msg.release());
+      }
+    }
+    if (cache->free.empty()) {
+      allocated_.fetch_add(1, std::memory_order_relaxed);
+      std::unique_ptr<T> msg(new T);
+      msg->pool_cache = cache;
+      return msg;
+    }
+
+    std::unique_ptr<T> msg(cache->free.back());
+    cache->free.pop_back();
+    msg->Reset();
+    return msg;
+  }
+
+  // Returns a message acquired from this pool, from any thread.
+  void Recycle(std::unique_ptr<T> &&msg) {
+    static_cast<Cache *>(msg->pool_cache)->returned.Enqueue(std::move(msg));
+  }
+
+  // Number of messages allocated so far.
+  uint64_t GetAllocated() const {
+    return allocated_.load(std::memory_order_relaxed);
+  }
+
+  // Number of thread caches, threads that come and go share them.
+  size_t GetCaches() const {
+    std::unique_lock<std::mutex> lock(shared_->lock);
+    return shared_->caches.size();
+  }
+
+ private:
+  struct Cache {
+    std::vector<T *> free;
+    lock_free::MpscQueue<T> returned;
+
+    ~Cache() {
+      for (T *msg : free) {
+        delete msg;
+      }
+    }
+  };
+
+  // What the threads holding caches of the pool share with it.
+  struct Shared {
+    std::mutex lock;
+    std::list<std::unique_ptr<Cache>> caches;
+    std::vector<Cache *> orphans;  // of the threads that have exited
+  };
+
+  // Caches of a thread, orphaned when it exits.
+  struct ThreadCaches {
+    struct Entry {
+      uint64_t pool_id;
+      std::weak_ptr<Shared> shared;
+      Cache *cache;
+    };
+
+    std::vector<Entry> entries;
+
+    ~ThreadCaches() {
+      for (const Entry &entry : entries) {
+        if (std::shared_ptr<Shared> shared = entry.shared.lock()) {
+          std::unique_lock<std::mutex> lock(shared->lock);
+          shared->orphans.push_back(entry.cache);
+        }
+      }
+    }
+  };
+
+  static inline std::atomic_uint64_t next_id_ = 0;
+
+  // Identifies the pool in the thread caches, unlike its address it is
+  // never reused.
+  const uint64_t id_;
+  std::atomic_uint64_t allocated_;
+  std::shared_ptr<Shared> shared_;
+
+  Cache *ThreadCache() {
+    static thread_local ThreadCaches caches;
+    for (const auto &entry : caches.entries) {
+      if (entry.pool_id == id_) {
+        return entry.cache;
+      }
+    }
+    return NewThreadCache(caches);
+  }
+
+  Cache *NewThreadCache(ThreadCaches &caches) {
+    std::erase_if(caches.entries, [](const auto &entry) {
+      return entry.shared.expired();
+    });
+
+    Cache *cache;
+    {
+      std::unique_lock<std::mutex> lock(shared_->lock);
+      if (!shared_->orphans.empty()) {
+        // Its returned queue had a single consumer, which is gone.
+        cache = shared_->orphans.back();
+        shared_->orphans.pop_back();
+      } else {
+        cache = new Cache;
+        shared_->caches.emplace_back(cache);
+      }
+    }
+    caches.entries.push_back({id_, shared_, cache});
+    return cache;
+  }
+};
+
+#endif  // MESSAGE_POOL_H
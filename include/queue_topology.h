@@ -0,0 +1,50 @@
+#ifndef QUEUE_TOPOLOGY_H
+#define QUEUE_TOPOLOGY_H
+
+#include "lock-free/bounded_ring.h"
+
+// Number of threads each component runs on its side of the queues. The
+// ring queues in queue_types.h are specialized for these, main checks that
+// the configuration keeps them.
+template <typename Component>
+struct QueueTopology;
+
+class Logger;
+class TaskGenerator;
+class ThreadPool;
+
+// Generator threads produce tasks; SINGLE_TASK_GENERATOR pins them to one.
+template <>
+struct QueueTopology<TaskGenerator> {
+#ifdef SINGLE_TASK_GENERATOR
+  static constexpr lock_free::Producers kTasksProducers =
+      lock_free::Producers::kSingle;
+#else   // SINGLE_TASK_GENERATOR
+  static constexpr lock_free::Producers kTasksProducers =
+      lock_free::Producers::kMulti;
+#endif  // SINGLE_TASK_GENERATOR
+};
+
+// Workers consume tasks and produce log messages; SINGLE_WORKER pins the
+// pool to one worker. Tasks run by generators under the caller_runs policy
+// log too, so the log side is always shared.
+template <>
+struct QueueTopology<ThreadPool> {
+#ifdef SINGLE_WORKER
+  static constexpr lock_free::Consumers kTasksConsumers =
+      lock_free::Consumers::kSingle;
+#else   // SINGLE_WORKER
+  static constexpr lock_free::Consumers kTasksConsumers =
+      lock_free::Consumers::kMulti;
+#endif  // SINGLE_WORKER
+  static constexpr lock_free::Producers kLogProducers =
+      lock_free::Producers::kMulti;
+};
+
+template <>
+struct QueueTopology<Logger> {
+  static constexpr lock_free::Consumers kLogConsumers =
+      lock_free::Consumers::kSingle;
+};
+
+#endif  // QUEUE_TOPOLOGY_H
@@ -3,26 +3,103 @@
 
 #include <functional>
 
-class LogMessage;
+#include "bounded_queue.h"
+#include "lock-free/bounded_ring.h"
+#include "lock-free/mpsc_queue.h"
+#include "queue_topology.h"
+
+struct LogMessage;
+
+// Registers the calling thread with a queue that keeps per-thread state
+// (hazard pointer rows), nothing for the other queues. A thread must be
+// registered with every queue it uses.
+template <typename Queue>
+void RegisterQueueThread(Queue &queue) {
+  if constexpr (requires { queue.RegisterThread(); }) {
+    queue.RegisterThread();
+  }
+}
+
+template <typename Queue>
+void UnregisterQueueThread(Queue &queue) {
+  if constexpr (requires { queue.UnregisterThread(); }) {
+    queue.UnregisterThread();
+  }
+}
 
 #ifdef LOCK_FREE
+#include "adaptive_queue.h"
+#include "lock-free/faa_queue.h"
+#include "lock/flat_combining_queue.h"
+#include "lock/multi_queue.h"
 #include "lock-free/ring_buffer.h"
 #include "lock-free/linked_queue.h"
 
+// The tasks queue is selected with the LOCK_FREE_TASKS_QUEUE CMake option.
 //typedef lock_free::RingBuffer<std::function<void()>> TasksQueue;
-typedef lock_free::LinkedQueue<std::function<void()>> TasksQueue;
-
-//typedef lock_free::RingBuffer<std::unique_ptr<LogMessage>> LoggerQueue;
-typedef lock_free::LinkedQueue<std::unique_ptr<LogMessage>> LoggerQueue;
+#if defined(TASKS_QUEUE_FAA)
+typedef BoundedQueue<lock_free::FaaArrayQueue<std::function<void()>>>
+    TasksQueue;
+#elif defined(TASKS_QUEUE_MULTI)
+typedef BoundedQueue<locks::MultiQueue<std::function<void()>>> TasksQueue;
+#elif defined(TASKS_QUEUE_FLAT_COMBINING)
+typedef BoundedQueue<locks::FlatCombiningQueue<std::function<void()>>>
+    TasksQueue;
+#elif defined(TASKS_QUEUE_ADAPTIVE)
+typedef BoundedQueue<AdaptiveQueue<std::function<void()>>> TasksQueue;
+#elif defined(TASKS_QUEUE_RING)
+typedef BoundedQueue<lock_free::BoundedRing<
+    std::function<void()>, QueueTopology<TaskGenerator>::kTasksProducers,
+    QueueTopology<ThreadPool>::kTasksConsumers, RING_CAPACITY>>
+    TasksQueue;
+#else   // TASKS_QUEUE_LINKED
+typedef BoundedQueue<lock_free::LinkedQueue<std::function<void()>>>
+    TasksQueue;
+#endif  // TASKS_QUEUE_FAA
 #else  // LOCK_FREE
 #include "lock/ring_buffer.h"
 #include "lock/linked_queue.h"
+#include "lock/lock_policies.h"
+#include "lock/multi_queue.h"
+#include "lock/two_lock_queue.h"
 
-//typedef locks::RingBufferThreadSafe<std::function<void()>> TasksQueue;
-typedef locks::LinkedQueueThreadSafe<std::function<void()>> TasksQueue;
+// The queue lock is selected with the LOCK_QUEUE_LOCK CMake option.
+#if defined(QUEUE_LOCK_TTAS)
+typedef locks::TtasLock QueueLock;
+#elif defined(QUEUE_LOCK_TICKET)
+typedef locks::TicketLock QueueLock;
+#elif defined(QUEUE_LOCK_MCS)
+typedef locks::McsLock QueueLock;
+#elif defined(QUEUE_LOCK_SPIN_FUTEX)
+typedef locks::SpinFutexLock QueueLock;
+#else   // QUEUE_LOCK_MUTEX
+typedef locks::MutexLock QueueLock;
+#endif  // QUEUE_LOCK_TTAS
 
-//typedef locks::RingBufferThreadSafe<std::unique_ptr<LogMessage>> LoggerQueue;
-typedef locks::LinkedQueueThreadSafe<std::unique_ptr<LogMessage>> LoggerQueue;
+// The tasks queue is selected with the LOCK_TASKS_QUEUE CMake option.
+//typedef locks::RingBufferThreadSafe<std::function<void()>> TasksQueue;
+#if defined(TASKS_QUEUE_TWO_LOCK)
+typedef BoundedQueue<locks::TwoLockQueue<std::function<void()>, QueueLock>>
+    TasksQueue;
+#elif defined(TASKS_QUEUE_MULTI)
+typedef BoundedQueue<locks::MultiQueue<std::function<void()>, QueueLock>>
+    TasksQueue;
+#else   // TASKS_QUEUE_LINKED
+typedef BoundedQueue<
+    locks::LinkedQueueThreadSafe<std::function<void()>, QueueLock>>
+    TasksQueue;
+#endif  // TASKS_QUEUE_TWO_LOCK
 #endif  // LOCK_FREE
 
+// Many producers and the logger thread as the only consumer, in both
+// builds: the lock build sleeps in DequeueAll, the lock-free one polls.
+#if defined(LOCK_FREE) && defined(LOG_QUEUE_RING)
+typedef BoundedQueue<lock_free::BoundedRing<
+    std::unique_ptr<LogMessage>, QueueTopology<ThreadPool>::kLogProducers,
+    QueueTopology<Logger>::kLogConsumers, RING_CAPACITY>>
+    LoggerQueue;
+#else   // LOG_QUEUE_MPSC
+typedef BoundedQueue<lock_free::MpscQueue<LogMessage>> LoggerQueue;
+#endif  // LOG_QUEUE_RING
+
 #endif  // IQUEUE_H
\ No newline at end of file
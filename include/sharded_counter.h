@@ -0,0 +1,124 @@
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "cache_line.h"
+
+// Number of cells of the sharded primitives. Threads beyond it share cells
+// with others, which costs contention but stays correct.
+constexpr size_t kCounterShards = 64;
+
+// Cell of the calling thread: threads are numbered in order of their first
+// call, so up to kCounterShards threads each get a cell of their own.
+inline size_t ThreadShard() {
+  static std::atomic_size_t next_shard = 0;
+  thread_local size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kCounterShards;
+  return shard;
+}
+
+// Counter split into cache-line-padded per-thread cells. Add is a relaxed
+// RMW on a line the calling thread normally has to itself, Read sums the
+// cells, so it sees every Add that happens before it and maybe some of the
+// concurrent ones.
+class ShardedCounter {
+ public:
+  ShardedCounter() = default;
+  ShardedCounter(const ShardedCounter &) = delete;
+
+  void Add(uint64_t n = 1) {
+    cells_[ThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint64_t Read() const {
+    uint64_t sum = 0;
+    for (const auto &cell : cells_) {
+      sum += cell.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  void Reset() {
+    for (auto &cell : cells_) {
+      cell.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  CacheLinePadded<std::atomic_uint64_t> cells_[kCounterShards] = {};
+};
+
+// Count, sum, min and max of a stream of values, sharded like
+// ShardedCounter. Read merges the cells.
+class ShardedStats {
+ public:
+  struct Summary {
+    uint64_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+
+    double Mean() const { return count != 0 ? sum / count : 0; }
+  };
+
+  ShardedStats() { Reset(); }
+  ShardedStats(const ShardedStats &) = delete;
+
+  void Add(double value) {
+    Cell &cell = cells_[ThreadShard()];
+    cell.count.fetch_add(1, std::memory_order_relaxed);
+    cell.sum.fetch_add(value, std::memory_order_relaxed);
+    double min = cell.min.load(std::memory_order_relaxed);
+    while (value < min && !cell.min.compare_exchange_weak(
+                              min, value, std::memory_order_relaxed)) {
+    }
+    double max = cell.max.load(std::memory_order_relaxed);
+    while (value > max && !cell.max.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  Summary Read() const {
+    Summary summary;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -min;
+    for (const Cell &cell : cells_) {
+      summary.count += cell.count.load(std::memory_order_relaxed);
+      summary.sum += cell.sum.load(std::memory_order_relaxed);
+      min = std::min(min, cell.min.load(std::memory_order_relaxed));
+      max = std::max(max, cell.max.load(std::memory_order_relaxed));
+    }
+    if (summary.count != 0) {
+      summary.min = min;
+      summary.max = max;
+    }
+    return summary;
+  }
+
+  void Reset() {
+    for (Cell &cell : cells_) {
+      cell.count.store(0, std::memory_order_relaxed);
+      cell.sum.store(0, std::memory_order_relaxed);
+      cell.min.store(std::numeric_limits<double>::infinity(),
+                     std::memory_order_relaxed);
+      cell.max.store(-std::numeric_limits<double>::infinity(),
+                     std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  struct alignas(kCacheLineSize) Cell {
+    std::atomic_uint64_t count;
+    std::atomic<double> sum;
+    std::atomic<double> min;
+    std::atomic<double> max;
+  };
+
+  Cell cells_[kCounterShards];
+};
+
+#endif  // SHARDED_COUNTER_H
@@ -2,41 +2,92 @@
 #define TASK_GENERATOR_H
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <vector>
 
+#include "cache_line.h"
+#include "config.h"
+#include "lock-free/segmented_vector.h"
 #include "queue_types.h"
+#include "sharded_counter.h"
 
+class LatencyHistogram;
 class Logger;
 
+struct LoadProfile {
+  LoadMode mode = LoadMode::kClosed;
+  double tasks_rate = 0;  // tasks per second over all generator threads
+};
+
+struct TaskResult {
+  size_t num;
+  double a;
+  double b;
+  double result;
+};
+
+// Filled in by the tasks as they complete, from any worker thread. Every
+// result is kept in `outputs` only if keep_outputs is set.
+struct TaskStats {
+  ShardedCounter completed;
+  ShardedStats results;
+  bool keep_outputs = false;
+  lock_free::SegmentedVector<TaskResult> outputs;
+};
+
 class TaskGenerator {
  public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Task latency is recorded into `latency` when a task completes. In open
+  // loop modes it is measured from the scheduled send time rather than the
+  // actual one, so a generator stalled by a saturated queue does not hide
+  // the queueing delay (coordinated omission).
+  //
+  // Generator threads take task numbers in batches of batch_size with one
+  // RMW on the shared counter per batch; numbers are then unique but not
+  // issued in order across threads.
   TaskGenerator(size_t numThreads, TasksQueue &tasks, Logger &logger,
-                size_t max_tasks_num, std::atomic_int &task_counter);
+                size_t max_tasks_num, size_t batch_size, TaskStats &stats,
+                const LoadProfile &load, LatencyHistogram &latency);
 
   TaskGenerator(const TaskGenerator &) = delete;
 
   template <class F, class... Args>
   void AddTask(F &&f, Args &&...args) {
-    tasks_.Enqueue([f = std::forward<F>(f),
-                    args = std::make_tuple(std::forward<Args>(args)...)] {
-      std::apply(f, args);
-    });
+    std::function<void()> task(
+        [f = std::forward<F>(f),
+         args = std::make_tuple(std::forward<Args>(args)...)] {
+          std::apply(f, args);
+        });
+    if (!tasks_.Enqueue(std::move(task)) &&
+        tasks_.GetPolicy() == AdmissionPolicy::kCallerRuns) {
+      task();
+    }
   }
 
   void Stop();
   void Join();
 
+  Clock::time_point GetStartTime() const { return start_time_; }
+  size_t GetGeneratedTasksNumber() const { return gen_tasks_.Read(); }
+
  private:
   TasksQueue &tasks_;
   Logger &logger_;
+  LatencyHistogram &latency_;
+  Clock::time_point start_time_;
 
-  std::atomic_size_t gen_tasks_;
-  std::atomic_int &task_counter_;
+  TaskStats &stats_;
   size_t max_tasks_num_;
+  size_t batch_size_;
+
+  alignas(kCacheLineSize) std::atomic_size_t next_task_;
+  ShardedCounter gen_tasks_;
 
   std::vector<std::thread> threads_;
-  std::atomic_bool need_stop_;
+  alignas(kCacheLineSize) std::atomic_bool need_stop_;
 };
 
 #endif  // TASK_GENERATOR_H
\ No newline at end of file
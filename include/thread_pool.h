@@ -2,24 +2,66 @@
 #define THREAD_POOL_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <thread>
 
+#include "cache_line.h"
 #include "queue_types.h"
 
 class ThreadPool {
  public:
   ThreadPool(TasksQueue &tasks, LoggerQueue &logger_queue, size_t numThreads);
 
+  // Elastic pool: starts with minThreads workers, spawns more (up to
+  // maxThreads) while the tasks queue stays backlogged and retires workers
+  // that have been idle for idle_timeout.
+  ThreadPool(TasksQueue &tasks, LoggerQueue &logger_queue, size_t minThreads,
+             size_t maxThreads, std::chrono::milliseconds idle_timeout);
+
   void Stop();
   void Join();
 
+  size_t GetPeakThreadsNumber() const { return peak_threads_; }
+  size_t GetSpawnedThreadsNumber() const { return spawned_threads_; }
+  size_t GetRetiredThreadsNumber() const { return retired_threads_; }
+
  private:
+  struct Worker {
+    std::thread thread;
+    std::atomic_bool finished = false;
+  };
+
   TasksQueue &tasks_;
   LoggerQueue &logger_queue_;
 
-  std::vector<std::thread> threads_;
-  std::atomic_bool need_stop_;
+  const size_t min_threads_;
+  const size_t max_threads_;
+  const std::chrono::milliseconds idle_timeout_;
+  const bool elastic_;
+
+  std::mutex workers_lock_;
+  std::list<std::unique_ptr<Worker>> workers_;
+  std::thread controller_;
+
+  // need_stop_ is polled by every idle worker, keep it on a line that is
+  // never written while the pool runs.
+  alignas(kCacheLineSize) std::atomic_bool need_stop_;
+  alignas(kCacheLineSize) std::atomic_size_t live_threads_;
+  std::atomic_size_t peak_threads_;
+  std::atomic_size_t spawned_threads_;
+  std::atomic_size_t retired_threads_;
+  alignas(kCacheLineSize) std::atomic_size_t idle_threads_;
+
+  void SpawnWorker();
+  void RunWorker(Worker *worker);
+  bool WaitTask(std::function<void()> &task);
+  bool TryRetire();
+  void RunController();
+  void ReapWorkers();
 };
 
-#endif  // THREAD_POOL_H
\ No newline at end of file
+#endif  // THREAD_POOL_H
@@ -34,11 +34,27 @@ void Config::Parse(std::istream *is) { impl_->Parse(is); }
 //{
 //  "app": {
 //    "threads_number": 16,
+//    "min_threads_number": 2,
+//    "max_threads_number": 32,
+//    "thread_idle_timeout_ms": 1000,
 //    "task_gen_threads_number": 8,
+//    "task_gen_batch_size": 16,
 //    "tasks_buffer_size": 128,
 //    "log_buffer_size": 256,
+//    "tasks_admission_policy": "block",
+//    "log_admission_policy": "reject",
 //    "tasks_number": 1000,
-//    "log_file_path": "test.log"
+//    "log_file_path": "test.log",
+//    "log_mirror_paths": ["mirror.log"],
+//    "log_format": "text",
+//    "log_pattern": "%d  %l %f:%n %m",
+//    "log_level": "info",
+//    "log_disabled_sites": ["task_generator.cpp:144"],
+//    "results_file_path": "results.csv",
+//    "hazard_fence": "asymmetric",
+//    "load_mode": "poisson",
+//    "tasks_rate": 2000,
+//    "rate_sweep": [500, 1000, 2000, 4000]
 //  }
 //}
 
@@ -85,6 +101,39 @@ void Config::ConfigImpl::ParseApp(const json::value &app_json) {
         static_cast<size_t>(threads_number_json.get<double>());
   }
 
+  auto &min_threads_number_json = app_json.get("min_threads_number");
+  if (!min_threads_number_json.is<json::null>()) {
+    if (!min_threads_number_json.is<double>()) {
+      throw std::invalid_argument(
+          "Config app min_threads_number must be a number");
+    }
+
+    config_->min_threads_number_ =
+        static_cast<size_t>(min_threads_number_json.get<double>());
+  }
+
+  auto &max_threads_number_json = app_json.get("max_threads_number");
+  if (!max_threads_number_json.is<json::null>()) {
+    if (!max_threads_number_json.is<double>()) {
+      throw std::invalid_argument(
+          "Config app max_threads_number must be a number");
+    }
+
+    config_->max_threads_number_ =
+        static_cast<size_t>(max_threads_number_json.get<double>());
+  }
+
+  auto &thread_idle_timeout_ms_json = app_json.get("thread_idle_timeout_ms");
+  if (!thread_idle_timeout_ms_json.is<json::null>()) {
+    if (!thread_idle_timeout_ms_json.is<double>()) {
+      throw std::invalid_argument(
+          "Config app thread_idle_timeout_ms must be a number");
+    }
+
+    config_->thread_idle_timeout_ms_ =
+        static_cast<size_t>(thread_idle_timeout_ms_json.get<double>());
+  }
+
   auto &task_gen_threads_number_json = app_json.get("task_gen_threads_number");
   if (!task_gen_threads_number_json.is<json::null>()) {
     if (!task_gen_threads_number_json.is<double>()) {
@@ -95,6 +144,18 @@ void Config::ConfigImpl::ParseApp(const json::value &app_json) {
         static_cast<size_t>(task_gen_threads_number_json.get<double>());
   }
 
+  auto &task_gen_batch_size_json = app_json.get("task_gen_batch_size");
+  if (!task_gen_batch_size_json.is<json::null>()) {
+    if (!task_gen_batch_size_json.is<double>() ||
+        task_gen_batch_size_json.get<double>() < 1) {
+      throw std::invalid_argument(
+          "Config app task_gen_batch_size must be a positive number");
+    }
+
+    config_->task_gen_batch_size_ =
+        static_cast<size_t>(task_gen_batch_size_json.get<double>());
+  }
+
   auto &tasks_buffer_size_json = app_json.get("tasks_buffer_size");
   if (!tasks_buffer_size_json.is<json::null>()) {
     if (!tasks_buffer_size_json.is<double>()) {
@@ -117,6 +178,30 @@ void Config::ConfigImpl::ParseApp(const json::value &app_json) {
         static_cast<size_t>(log_buffer_size_json.get<double>());
   }
 
+  auto &tasks_admission_policy_json = app_json.get("tasks_admission_policy");
+  if (!tasks_admission_policy_json.is<json::null>()) {
+    if (!tasks_admission_policy_json.is<std::string>() ||
+        !ParseAdmissionPolicy(tasks_admission_policy_json.get<std::string>(),
+                              config_->tasks_admission_policy_)) {
+      throw std::invalid_argument(
+          "Config app tasks_admission_policy must be one of: block, reject, "
+          "drop_oldest, caller_runs");
+    }
+  }
+
+  auto &log_admission_policy_json = app_json.get("log_admission_policy");
+  if (!log_admission_policy_json.is<json::null>()) {
+    if (!log_admission_policy_json.is<std::string>() ||
+        !ParseAdmissionPolicy(log_admission_policy_json.get<std::string>(),
+                              config_->log_admission_policy_) ||
+        config_->log_admission_policy_ == AdmissionPolicy::kCallerRuns ||
+        config_->log_admission_policy_ == AdmissionPolicy::kDropOldest) {
+      // The log queue has a single consumer, producers may not dequeue.
+      throw std::invalid_argument(
+          "Config app log_admission_policy must be one of: block, reject");
+    }
+  }
+
   auto &tasks_number_json = app_json.get("tasks_number");
   if (!tasks_number_json.is<json::null>()) {
     if (!tasks_number_json.is<double>()) {
@@ -135,4 +220,142 @@ void Config::ConfigImpl::ParseApp(const json::value &app_json) {
 
     config_->log_file_path_ = log_file_path_json.to_str();
   }
+
+  auto &log_mirror_paths_json = app_json.get("log_mirror_paths");
+  if (!log_mirror_paths_json.is<json::null>()) {
+    if (!log_mirror_paths_json.is<json::array>()) {
+      throw std::invalid_argument(
+          "Config app log_mirror_paths must be an array");
+    }
+
+    config_->log_mirror_paths_.clear();
+    for (auto &path_json : log_mirror_paths_json.get<json::array>()) {
+      if (!path_json.is<std::string>()) {
+        throw std::invalid_argument(
+            "Config app log_mirror_paths must contain strings");
+      }
+      config_->log_mirror_paths_.push_back(path_json.get<std::string>());
+    }
+  }
+
+  auto &log_format_json = app_json.get("log_format");
+  if (!log_format_json.is<json::null>()) {
+    if (!log_format_json.is<std::string>() ||
+        !ParseLogFormat(log_format_json.get<std::string>(),
+                        config_->log_format_)) {
+      throw std::invalid_argument(
+          "Config app log_format must be one of: text, binary");
+    }
+  }
+
+  auto &log_pattern_json = app_json.get("log_pattern");
+  if (!log_pattern_json.is<json::null>()) {
+    if (!log_pattern_json.is<std::string>()) {
+      throw std::invalid_argument("Config app log_pattern must be a string");
+    }
+
+    try {
+      LogPattern pattern(log_pattern_json.get<std::string>());
+    } catch (std::invalid_argument &e) {
+      throw std::invalid_argument(std::string("Config app log_pattern: ") +
+                                  e.what());
+    }
+    config_->log_pattern_ = log_pattern_json.get<std::string>();
+  }
+
+  auto &log_level_json = app_json.get("log_level");
+  if (!log_level_json.is<json::null>()) {
+    if (!log_level_json.is<std::string>() ||
+        !ParseLogLevel(log_level_json.get<std::string>(),
+                       config_->log_level_)) {
+      throw std::invalid_argument(
+          "Config app log_level must be one of: trace, debug, info, warning, "
+          "error");
+    }
+  }
+
+  auto &log_disabled_sites_json = app_json.get("log_disabled_sites");
+  if (!log_disabled_sites_json.is<json::null>()) {
+    if (!log_disabled_sites_json.is<json::array>()) {
+      throw std::invalid_argument(
+          "Config app log_disabled_sites must be an array");
+    }
+
+    config_->log_disabled_sites_.clear();
+    for (auto &site_json : log_disabled_sites_json.get<json::array>()) {
+      if (!site_json.is<std::string>()) {
+        throw std::invalid_argument(
+            "Config app log_disabled_sites must contain strings");
+      }
+      config_->log_disabled_sites_.push_back(site_json.get<std::string>());
+    }
+  }
+
+  auto &results_file_path_json = app_json.get("results_file_path");
+  if (!results_file_path_json.is<json::null>()) {
+    if (!results_file_path_json.is<std::string>()) {
+      throw std::invalid_argument(
+          "Config app results_file_path must be a string");
+    }
+
+    config_->results_file_path_ = results_file_path_json.to_str();
+  }
+
+  auto &hazard_fence_json = app_json.get("hazard_fence");
+  if (!hazard_fence_json.is<json::null>()) {
+    if (!hazard_fence_json.is<std::string>() ||
+        (hazard_fence_json.get<std::string>() != "symmetric" &&
+         hazard_fence_json.get<std::string>() != "asymmetric")) {
+      throw std::invalid_argument(
+          "Config app hazard_fence must be one of: symmetric, asymmetric");
+    }
+
+    config_->asymmetric_hazard_fence_ =
+        hazard_fence_json.get<std::string>() == "asymmetric";
+  }
+
+  auto &load_mode_json = app_json.get("load_mode");
+  if (!load_mode_json.is<json::null>()) {
+    if (!load_mode_json.is<std::string>()) {
+      throw std::invalid_argument("Config app load_mode must be a string");
+    }
+
+    const std::string &load_mode = load_mode_json.get<std::string>();
+    if (load_mode == "closed") {
+      config_->load_mode_ = LoadMode::kClosed;
+    } else if (load_mode == "constant") {
+      config_->load_mode_ = LoadMode::kConstant;
+    } else if (load_mode == "poisson") {
+      config_->load_mode_ = LoadMode::kPoisson;
+    } else {
+      throw std::invalid_argument(
+          "Config app load_mode must be one of: closed, constant, poisson");
+    }
+  }
+
+  auto &tasks_rate_json = app_json.get("tasks_rate");
+  if (!tasks_rate_json.is<json::null>()) {
+    if (!tasks_rate_json.is<double>() || tasks_rate_json.get<double>() <= 0) {
+      throw std::invalid_argument(
+          "Config app tasks_rate must be a positive number");
+    }
+
+    config_->tasks_rate_ = tasks_rate_json.get<double>();
+  }
+
+  auto &rate_sweep_json = app_json.get("rate_sweep");
+  if (!rate_sweep_json.is<json::null>()) {
+    if (!rate_sweep_json.is<json::array>()) {
+      throw std::invalid_argument("Config app rate_sweep must be an array");
+    }
+
+    config_->rate_sweep_.clear();
+    for (auto &rate_json : rate_sweep_json.get<json::array>()) {
+      if (!rate_json.is<double>() || rate_json.get<double>() <= 0) {
+        throw std::invalid_argument(
+            "Config app rate_sweep must contain positive numbers");
+      }
+      config_->rate_sweep_.push_back(rate_json.get<double>());
+    }
+  }
 }
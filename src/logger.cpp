@@ -1,40 +1,82 @@
 #include "logger.h"
 
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <ctime>
+#include <string>
 #include <thread>
+#include <vector>
+
+#include "binary_log.h"
+#include "lock-free/multicast_ring.h"
 
 namespace {
-std::string serializeLogMeassage(const LogMessage &msg) {
-  std::ostringstream record_stream;
-  record_stream << std::put_time(std::localtime(&msg.time), "%Y-%m-%d %H:%M:%S")
-                << "  " << msg.fname << ":" << msg.line_num << " "
-                << msg.smsg.str() << std::endl;
+// Formats records into a string, replacing its contents but keeping its
+// buffer, so a reused record stops allocating once it has grown to the
+// longest one.
+class LogSerializer {
+ public:
+  LogSerializer(LogFormat format, const LogPattern &pattern)
+      : format_(format), pattern_(pattern) {}
 
-  return record_stream.str();
-}
+  // The start of the file, empty for text.
+  void Begin(std::string &record) {
+    record.clear();
+    if (format_ == LogFormat::kBinary) {
+      binary_.Begin(record);
+    }
+  }
+
+  void Serialize(const LogMessage &msg, std::string &record) {
+    if (format_ == LogFormat::kBinary) {
+      binary_.Write(msg.time, *msg.site, msg.args, record);
+      return;
+    }
+    pattern_.Format(time_,
+                    {msg.time, msg.site->GetLevel(), msg.site->GetFile(),
+                     msg.site->GetLine(), msg.site->GetFormat(), msg.args},
+                    record);
+  }
+
+ private:
+  LogFormat format_;
+  const LogPattern &pattern_;
+  LogTimeFormatter time_;
+  BinaryLogWriter binary_;
+};
 }  // namespace
 
-FileLogAppender::FileLogAppender(std::string file_path)
-    : log_file_(file_path) {}
+FileLogAppender::FileLogAppender(std::string file_path, bool append)
+    : log_file_(file_path, append ? std::ios::app : std::ios::trunc) {}
 FileLogAppender::~FileLogAppender() {
   log_file_.flush();
   log_file_.close();
 }
 
-bool FileLogAppender::Write(std::string msg) {
+bool FileLogAppender::Write(std::string_view msg) {
   log_file_.write(msg.data(), msg.size());
   return true;
 }
 
-Logger::Logger(LoggerQueue &logger_queue, LogAppender *helper)
-    : Runnable(), appender_(helper), logger_queue_(logger_queue) {}
+Logger::Logger(LoggerQueue &logger_queue, LogAppender *helper,
+               LogFormat format, std::string_view pattern)
+    : Runnable(), format_(format), pattern_(pattern),
+      logger_queue_(logger_queue) {
+  appenders_.emplace_back(helper);
+}
 
-bool Logger::AddMessage(std::unique_ptr<LogMessage> &&msg) {
-  logger_queue_.Enqueue(std::move(msg));
+void Logger::AddAppender(LogAppender *appender) {
+  appenders_.emplace_back(appender);
+}
 
-  return true;
+bool Logger::AddMessage(std::unique_ptr<LogMessage> &&msg) {
+  if (logger_queue_.Enqueue(std::move(msg))) {
+    return true;
+  }
+  // Not admitted, the message is still ours.
+  if (msg != nullptr) {
+    pool_.Recycle(std::move(msg));
+  }
+  return false;
 }
 
 void Logger::Stop() {
@@ -45,24 +87,85 @@ void Logger::Stop() {
 #endif  // LOCK_FREE
 }
 
-void Logger::Run() {
-#ifdef LOCK_FREE
-  logger_queue_.RegisterThread();
-#endif
-  std::unique_ptr<LogMessage> msg;
+template <typename Write>
+void Logger::Drain(Write write) {
+  // The logger is the only consumer, so it takes everything queued at once.
+  std::vector<std::unique_ptr<LogMessage>> batch;
   while (true) {
 #ifdef LOCK_FREE
-    while (!logger_queue_.TryDequeue(msg)) {
-      if (IsNeedStop()) {
+    // After the stop flag is seen the queue is polled once more: messages
+    // added before Stop() may have landed after our previous attempt.
+    bool stop = false;
+    while (logger_queue_.TryDequeueAll(batch) == 0) {
+      if (stop) {
         return;
       }
+      stop = IsNeedStop();
     }
 #else  // LOCK_FREE
-    if (!logger_queue_.Dequeue(msg)) {
+    if (logger_queue_.DequeueAll(batch) == 0) {
       return;
     }
 
 #endif  // LOCK_FREE
-    appender_->Write(serializeLogMeassage(*msg));
+    for (auto &msg : batch) {
+      write(*msg);
+      pool_.Recycle(std::move(msg));
+    }
+    batch.clear();
+  }
+}
+
+void Logger::Run() {
+  LogSerializer serializer(format_, pattern_);
+  std::string record;
+  serializer.Begin(record);
+  if (!record.empty()) {
+    for (auto &appender : appenders_) {
+      appender->Write(record);
+    }
+  }
+
+  if (appenders_.size() == 1) {
+    Drain([this, &serializer, &record](const LogMessage &msg) {
+      serializer.Serialize(msg, record);
+      appenders_[0]->Write(record);
+    });
+    return;
   }
-}
\ No newline at end of file
+
+  // The logger is the only producer of the ring, the appenders are
+  // independent consumers of the formatted records. Records are formatted
+  // straight into the claimed slot and read there, each slot string keeps
+  // its buffer from one lap to the next.
+  typedef lock_free::MulticastRing<std::string, lock_free::Producers::kSingle>
+      FanOutRing;
+  FanOutRing ring(kFanOutCapacity);
+  std::unique_ptr<lock_free::Sequence[]> sequences(
+      new lock_free::Sequence[appenders_.size()]);
+  for (size_t i = 0; i < appenders_.size(); ++i) {
+    ring.AddGatingSequence(&sequences[i]);
+  }
+  FanOutRing::Barrier barrier = ring.NewBarrier();
+
+  std::vector<std::thread> consumers;
+  for (size_t i = 0; i < appenders_.size(); ++i) {
+    consumers.emplace_back([this, &ring, &barrier, &sequences, i] {
+      ring.Process(barrier, sequences[i],
+                   [this, i](const std::string &record, bool) {
+                     appenders_[i]->Write(record);
+                   });
+    });
+  }
+
+  Drain([&ring, &serializer](const LogMessage &msg) {
+    int64_t seq = ring.Claim();
+    serializer.Serialize(msg, ring.Get(seq));
+    ring.Publish(seq);
+  });
+
+  ring.Stop();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+}
@@ -1,10 +1,330 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
+#include "adaptive_queue.h"
 #include "config.h"
+#include "latency_histogram.h"
+#include "lock/lock_policies.h"
 #include "logger.h"
 #include "task_generator.h"
 #include "thread_pool.h"
 
+namespace {
+struct AdmissionSummary {
+  AdmissionPolicy policy = AdmissionPolicy::kBlock;
+  uint64_t rejected = 0;
+  uint64_t dropped = 0;
+  uint64_t blocked = 0;
+  std::chrono::nanoseconds blocked_time{0};
+};
+
+template <typename Queue>
+AdmissionSummary GetAdmissionSummary(const Queue &queue) {
+  const AdmissionStats &stats = queue.GetStats();
+  AdmissionSummary summary;
+  summary.policy = queue.GetPolicy();
+  summary.rejected = stats.rejected;
+  summary.dropped = stats.dropped;
+  summary.blocked = stats.blocked;
+  summary.blocked_time = std::chrono::nanoseconds(stats.blocked_ns);
+  return summary;
+}
+
+struct PassSummary {
+  LoadProfile load;
+  double offered_rate = 0;
+  double issued_rate = 0;
+  double achieved_rate = 0;
+  size_t tasks_number = 0;
+  ShardedStats::Summary results;
+  std::chrono::duration<double> execution_time{0};
+  std::chrono::nanoseconds p50{0};
+  std::chrono::nanoseconds p90{0};
+  std::chrono::nanoseconds p99{0};
+  std::chrono::nanoseconds max{0};
+  AdmissionSummary tasks_admission;
+  AdmissionSummary log_admission;
+  size_t peak_threads = 0;
+  size_t spawned_threads = 0;
+  size_t retired_threads = 0;
+  uint64_t log_messages = 0;
+  std::vector<QueueModeTransition> tasks_transitions;
+  bool adaptive_tasks_queue = false;
+  locks::LockStatsTotal tasks_locks;
+  bool locked_tasks_queue = false;
+};
+
+// Returns false if the queue keeps no lock stats.
+template <typename Queue>
+bool GetLockStats(const Queue &queue, locks::LockStatsTotal &stats) {
+  if constexpr (requires { queue.GetLockStats(); }) {
+    stats = queue.GetLockStats();
+    return true;
+  }
+  return false;
+}
+
+// Returns false if the queue does not switch modes.
+template <typename Queue>
+bool GetModeTransitions(const Queue &queue,
+                        std::vector<QueueModeTransition> &transitions) {
+  if constexpr (requires { queue.GetTransitions(); }) {
+    transitions = queue.GetTransitions();
+    return true;
+  }
+  return false;
+}
+
+const char *LoadModeName(LoadMode mode) {
+  switch (mode) {
+    case LoadMode::kClosed:
+      return "closed";
+    case LoadMode::kConstant:
+      return "constant";
+    case LoadMode::kPoisson:
+      return "poisson";
+  }
+  return "unknown";
+}
+
+// Returns an error if a queue bounded by itself can't be built with the
+// configured buffer size: it can't be unbounded or exceed a static
+// capacity.
+template <typename Queue>
+std::string CheckQueueCapacity(const char *name, size_t size) {
+  if constexpr (requires { Queue::kBounded; }) {
+    if (size == 0) {
+      return std::string("the ") + name + " queue is a ring, " + name +
+             "_buffer_size must be positive";
+    }
+    if (Queue::kMaxCapacity != 0 && size > Queue::kMaxCapacity) {
+      return std::string("built with LOCK_FREE_RING_CAPACITY ") +
+             std::to_string(Queue::kMaxCapacity) + ", " + name +
+             "_buffer_size must not exceed it";
+    }
+  }
+  return "";
+}
+
+// Returns an error if the configuration runs more threads on a side of a
+// queue than its QueueTopology declares, or sizes a queue it can't build.
+std::string CheckQueueTopology(const Config &config) {
+  std::string error =
+      CheckQueueCapacity<TasksQueue>("tasks", config.GetTasksBufferSize());
+  if (error.empty()) {
+    error = CheckQueueCapacity<LoggerQueue>("log", config.GetLogBufferSize());
+  }
+  if (!error.empty()) {
+    return error;
+  }
+
+  if (QueueTopology<TaskGenerator>::kTasksProducers ==
+          lock_free::Producers::kSingle &&
+      config.GetTaskGeneratorThreadNumber() != 1) {
+    return "built with SINGLE_TASK_GENERATOR, task_gen_threads_number must "
+           "be 1";
+  }
+  if (QueueTopology<ThreadPool>::kTasksConsumers ==
+      lock_free::Consumers::kSingle) {
+    if (config.GetMaxThreadsNumber() != 1) {
+      return "built with SINGLE_WORKER, the pool must have 1 thread";
+    }
+    if (config.GetTasksAdmissionPolicy() == AdmissionPolicy::kDropOldest) {
+      // Producers would dequeue next to the worker.
+      return "built with SINGLE_WORKER, tasks_admission_policy can't be "
+             "drop_oldest";
+    }
+  }
+  return "";
+}
+
+// Writes the results as CSV in task number order, after the header unless
+// appended to the results of a previous pass.
+void SaveResults(const std::string &path, bool append,
+                 const lock_free::SegmentedVector<TaskResult> &outputs) {
+  std::vector<const TaskResult *> sorted;
+  sorted.reserve(outputs.Size());
+  outputs.ForEach([&sorted](size_t, const TaskResult &result) {
+    sorted.push_back(&result);
+  });
+  std::sort(sorted.begin(), sorted.end(),
+            [](const TaskResult *lhs, const TaskResult *rhs) {
+              return lhs->num < rhs->num;
+            });
+
+  std::ofstream file(path, append ? std::ios::app : std::ios::trunc);
+  if (!append) {
+    file << "num,a,b,result\n";
+  }
+  for (const TaskResult *result : sorted) {
+    file << result->num << "," << result->a << "," << result->b << ","
+         << result->result << "\n";
+  }
+}
+
+double ToMs(std::chrono::nanoseconds ns) {
+  return std::chrono::duration<double, std::milli>(ns).count();
+}
+
+PassSummary RunPass(const Config &config, const LoadProfile &load,
+                    bool append_log) {
+  TaskStats task_stats;
+  task_stats.keep_outputs = !config.GetResultsFilePath().empty();
+  LatencyHistogram latency;
+
+  auto ts = std::chrono::high_resolution_clock::now();
+
+  LoggerQueue logger_queue(config.GetLogBufferSize(),
+                           config.GetLogAdmissionPolicy());
+#ifdef LOCK_FREE
+  TasksQueue tasks_queue(config.GetTasksBufferSize(),
+                         config.GetTasksAdmissionPolicy(),
+                         config.GetMaxThreadsNumber() +
+                             config.GetTaskGeneratorThreadNumber());
+#else
+  TasksQueue tasks_queue(config.GetTasksBufferSize(),
+                         config.GetTasksAdmissionPolicy());
+#endif
+
+  Logger logger(logger_queue,
+                new FileLogAppender(config.GetLogFilePath(), append_log),
+                config.GetLogFormat(), config.GetLogPattern());
+  for (const std::string &path : config.GetLogMirrorPaths()) {
+    logger.AddAppender(new FileLogAppender(path, append_log));
+  }
+  logger.Start();
+
+  ThreadPool thread_pool(
+      tasks_queue, logger_queue, config.GetMinThreadsNumber(),
+      config.GetMaxThreadsNumber(),
+      std::chrono::milliseconds(config.GetThreadIdleTimeoutMs()));
+
+  TaskGenerator task_generator(config.GetTaskGeneratorThreadNumber(),
+                               tasks_queue, logger, config.GetTasksNumber(),
+                               config.GetTaskGeneratorBatchSize(), task_stats,
+                               load, latency);
+
+  if (config.GetTasksNumber() == 0) {
+    while (true) {
+      if (std::cin.get() == '\n') {
+        task_generator.Stop();
+        break;
+      }
+    }
+  }
+
+  task_generator.Join();
+  auto issue_end = TaskGenerator::Clock::now();
+  thread_pool.Stop();
+  thread_pool.Join();
+  auto complete_end = TaskGenerator::Clock::now();
+  logger.Stop();
+  logger.Join();
+
+  auto te = std::chrono::high_resolution_clock::now();
+
+  PassSummary summary;
+  summary.load = load;
+  summary.tasks_number = task_stats.completed.Read();
+  summary.results = task_stats.results.Read();
+  if (task_stats.keep_outputs) {
+    SaveResults(config.GetResultsFilePath(), append_log, task_stats.outputs);
+  }
+  summary.execution_time = te - ts;
+
+  std::chrono::duration<double> issue_time =
+      issue_end - task_generator.GetStartTime();
+  std::chrono::duration<double> complete_time =
+      complete_end - task_generator.GetStartTime();
+  summary.offered_rate = load.mode == LoadMode::kClosed
+                             ? 0
+                             : load.tasks_rate;
+  summary.issued_rate =
+      task_generator.GetGeneratedTasksNumber() / issue_time.count();
+  summary.achieved_rate = summary.tasks_number / complete_time.count();
+
+  summary.p50 = latency.Percentile(0.5);
+  summary.p90 = latency.Percentile(0.9);
+  summary.p99 = latency.Percentile(0.99);
+  summary.max = latency.Max();
+
+  summary.tasks_admission = GetAdmissionSummary(tasks_queue);
+  summary.log_admission = GetAdmissionSummary(logger_queue);
+
+  summary.peak_threads = thread_pool.GetPeakThreadsNumber();
+  summary.spawned_threads = thread_pool.GetSpawnedThreadsNumber();
+  summary.retired_threads = thread_pool.GetRetiredThreadsNumber();
+  summary.log_messages = logger.GetAllocatedMessages();
+
+  summary.adaptive_tasks_queue =
+      GetModeTransitions(tasks_queue, summary.tasks_transitions);
+  summary.locked_tasks_queue = GetLockStats(tasks_queue, summary.tasks_locks);
+
+  return summary;
+}
+
+void PrintAdmissionSummary(const char *name,
+                           const AdmissionSummary &summary) {
+  std::cout << name << " queue (" << AdmissionPolicyName(summary.policy)
+            << "): ";
+  if (summary.policy == AdmissionPolicy::kCallerRuns) {
+    std::cout << "run inline " << summary.rejected;
+  } else {
+    std::cout << "rejected " << summary.rejected;
+  }
+  std::cout << ", dropped " << summary.dropped << ", blocked "
+            << summary.blocked << " (" << ToMs(summary.blocked_time)
+            << " ms)" << std::endl;
+}
+
+void PrintPassSummary(const PassSummary &summary) {
+  std::cout << "Execution time: " << summary.execution_time << std::endl;
+  std::cout << "Tasks number: " << summary.tasks_number << std::endl;
+  std::cout << "Results mean/min/max: " << summary.results.Mean() << "/"
+            << summary.results.min << "/" << summary.results.max
+            << std::endl;
+  if (summary.load.mode != LoadMode::kClosed) {
+    std::cout << "Offered rate: " << summary.offered_rate << " tasks/s"
+              << std::endl;
+  }
+  std::cout << "Issued rate: " << summary.issued_rate << " tasks/s"
+            << std::endl;
+  std::cout << "Achieved rate: " << summary.achieved_rate << " tasks/s"
+            << std::endl;
+  std::cout << "Latency p50/p90/p99/max: " << ToMs(summary.p50) << "/"
+            << ToMs(summary.p90) << "/" << ToMs(summary.p99) << "/"
+            << ToMs(summary.max) << " ms" << std::endl;
+  PrintAdmissionSummary("Tasks", summary.tasks_admission);
+  PrintAdmissionSummary("Log", summary.log_admission);
+  std::cout << "Pool threads: peak " << summary.peak_threads << ", spawned "
+            << summary.spawned_threads << ", retired "
+            << summary.retired_threads << std::endl;
+  std::cout << "Log messages allocated: " << summary.log_messages
+            << std::endl;
+  if (summary.locked_tasks_queue) {
+    const locks::LockStatsTotal &locks = summary.tasks_locks;
+    std::cout << "Tasks queue locks: acquired " << locks.acquisitions
+              << ", contended " << locks.contended << ", waited "
+              << ToMs(std::chrono::nanoseconds(locks.wait_ns)) << " ms"
+              << std::endl;
+  }
+  if (summary.adaptive_tasks_queue) {
+    std::cout << "Tasks queue mode transitions: "
+              << summary.tasks_transitions.size();
+    for (const QueueModeTransition &transition : summary.tasks_transitions) {
+      std::cout << ", "
+                << ToMs(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       transition.at))
+                << " ms -> " << QueueModeName(transition.mode);
+    }
+    std::cout << std::endl;
+  }
+}
+}  // namespace
+
 int main(int argc, char *argv[]) {
 #ifdef LOCK_FREE
   std::cout << "lock free" << std::endl;
@@ -32,58 +352,96 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  std::cout << "Thread pool threads number: " << config.GetThreadsNumber()
-            << std::endl;
+  std::string topology_error = CheckQueueTopology(config);
+  if (!topology_error.empty()) {
+    std::cerr << "Configuration doesn't match queue topology: "
+              << topology_error << std::endl;
+    return 1;
+  }
+
+  std::cout << "Thread pool threads number: " << config.GetMinThreadsNumber();
+  if (config.GetMaxThreadsNumber() > config.GetMinThreadsNumber()) {
+    std::cout << ".." << config.GetMaxThreadsNumber() << " (idle timeout "
+              << config.GetThreadIdleTimeoutMs() << " ms)";
+  }
+  std::cout << std::endl;
   std::cout << "Task generator threads number: "
             << config.GetTaskGeneratorThreadNumber() << std::endl;
   std::cout << "Tasks buffer size: " << config.GetTasksBufferSize()
             << std::endl;
   std::cout << "Log buffer size: " << config.GetLogBufferSize() << std::endl;
+  std::cout << "Tasks admission policy: "
+            << AdmissionPolicyName(config.GetTasksAdmissionPolicy())
+            << std::endl;
+  std::cout << "Log admission policy: "
+            << AdmissionPolicyName(config.GetLogAdmissionPolicy())
+            << std::endl;
   std::cout << "Tasks number: " << config.GetTasksNumber() << std::endl;
   std::cout << "Log file path: " << config.GetLogFilePath() << std::endl;
-
-  std::atomic_int task_counter;
-
-  auto ts = std::chrono::high_resolution_clock::now();
+  for (const std::string &path : config.GetLogMirrorPaths()) {
+    std::cout << "Log mirror path: " << path << std::endl;
+  }
+  std::cout << "Log format: " << LogFormatName(config.GetLogFormat())
+            << std::endl;
+  std::cout << "Log pattern: " << config.GetLogPattern() << std::endl;
+  LogSites::SetLevel(config.GetLogLevel());
+  std::cout << "Log level: " << LogLevelName(config.GetLogLevel());
+  if (config.GetLogLevel() < kLogMinLevel) {
+    std::cout << " (" << LogLevelName(kLogMinLevel) << " at compile time)";
+  }
+  std::cout << std::endl;
+  for (const std::string &site : config.GetLogDisabledSites()) {
+    LogSites::SetSiteEnabled(site, false);
+    std::cout << "Log disabled site: " << site << std::endl;
+  }
+  if (!config.GetResultsFilePath().empty()) {
+    std::cout << "Results file path: " << config.GetResultsFilePath()
+              << std::endl;
+  }
 
 #ifdef LOCK_FREE
-  LoggerQueue logger_queue(config.GetTaskGeneratorThreadNumber() + 1);
-  TasksQueue tasks_queue(config.GetThreadsNumber() +
-                         config.GetTaskGeneratorThreadNumber());
-#else
-  LoggerQueue logger_queue;
-  TasksQueue tasks_queue;
-#endif
-
-  Logger logger(logger_queue, new FileLogAppender(config.GetLogFilePath()));
-  logger.Start();
-
-  ThreadPool thread_pool(tasks_queue, logger_queue, config.GetThreadsNumber());
-
-  TaskGenerator task_generator(config.GetTaskGeneratorThreadNumber(),
-                               tasks_queue, logger, config.GetTasksNumber(),
-                               task_counter);
-
-  if (config.GetTasksNumber() == 0) {
-    while (true) {
-      if (std::cin.get() == '\n') {
-        task_generator.Stop();
-        break;
-      }
-    }
+  // Must be set before any queue is used.
+  auto fence_mode = lock_free::AsymmetricFence::SetMode(
+      config.IsAsymmetricHazardFence() ? lock_free::FenceMode::kAsymmetric
+                                       : lock_free::FenceMode::kSymmetric);
+  std::cout << "Hazard pointer fence: "
+            << (fence_mode == lock_free::FenceMode::kAsymmetric
+                    ? "asymmetric (membarrier)"
+                    : "symmetric")
+            << std::endl;
+#endif  // LOCK_FREE
+  std::cout << "Load mode: " << LoadModeName(config.GetLoadMode())
+            << std::endl;
+  if (config.GetLoadMode() != LoadMode::kClosed) {
+    std::cout << "Tasks rate: " << config.GetTasksRate() << " tasks/s"
+              << std::endl;
   }
 
-  task_generator.Join();
-  thread_pool.Stop();
-  thread_pool.Join();
-  logger.Stop();
-  logger.Join();
+  if (config.GetRateSweep().empty()) {
+    LoadProfile load{config.GetLoadMode(), config.GetTasksRate()};
+    PrintPassSummary(RunPass(config, load, false));
+    return 0;
+  }
 
-  auto te = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> ms_double = te - ts;
-  std::cout << "Execution time: " << ms_double << std::endl;
+  // Rate sweep: one open loop pass per offered rate, to find the
+  // throughput/latency knee of the queue implementation.
+  LoadMode mode = config.GetLoadMode() == LoadMode::kClosed
+                      ? LoadMode::kPoisson
+                      : config.GetLoadMode();
+  std::vector<PassSummary> summaries;
+  for (double rate : config.GetRateSweep()) {
+    LoadProfile load{mode, rate};
+    summaries.push_back(RunPass(config, load, !summaries.empty()));
+    PrintPassSummary(summaries.back());
+  }
 
-  std::cout << "Tasks number: " << task_counter << std::endl;
+  std::cout << std::endl
+            << "offered/s  achieved/s  p50 ms  p99 ms  max ms" << std::endl;
+  for (const PassSummary &summary : summaries) {
+    std::cout << summary.offered_rate << "  " << summary.achieved_rate << "  "
+              << ToMs(summary.p50) << "  " << ToMs(summary.p99) << "  "
+              << ToMs(summary.max) << std::endl;
+  }
 
   return 0;
 }
\ No newline at end of file
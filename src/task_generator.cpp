@@ -1,8 +1,11 @@
 #include "task_generator.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <random>
 
+#include "latency_histogram.h"
 #include "logger.h"
 #include "thread_pool.h"
 
@@ -22,32 +25,105 @@ double integrate(double a, double b) {
 
   return sum * h;
 }
+
+// Arrival offsets (from the generator start) of one generator thread in open
+// loop mode. Offsets are computed in batches ahead of time so that drawing
+// random numbers stays off the send path.
+class ArrivalSchedule {
+ public:
+  ArrivalSchedule(const LoadProfile &load, size_t threads_num, size_t idx)
+      : mode_(load.mode),
+        interval_(load.tasks_rate > 0 ? threads_num / load.tasks_rate : 0),
+        rng_(idx + 1),
+        exp_dist_(interval_ > 0 ? 1.0 / interval_ : 1.0),
+        last_(0) {
+    if (mode_ == LoadMode::kConstant) {
+      // Spread the threads evenly so the aggregate stream is constant too.
+      last_ = interval_ * idx / threads_num - interval_;
+    }
+    offsets_.reserve(kBatchSize);
+  }
+
+  TaskGenerator::Clock::duration Next() {
+    if (pos_ == offsets_.size()) {
+      Refill();
+    }
+    return offsets_[pos_++];
+  }
+
+ private:
+  static constexpr size_t kBatchSize = 1024;
+
+  void Refill() {
+    offsets_.clear();
+    pos_ = 0;
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      last_ += mode_ == LoadMode::kPoisson ? exp_dist_(rng_) : interval_;
+      offsets_.push_back(
+          std::chrono::duration_cast<TaskGenerator::Clock::duration>(
+              std::chrono::duration<double>(last_)));
+    }
+  }
+
+  LoadMode mode_;
+  double interval_;  // mean seconds between two arrivals of this thread
+  std::mt19937_64 rng_;
+  std::exponential_distribution<double> exp_dist_;
+  double last_;
+  std::vector<TaskGenerator::Clock::duration> offsets_;
+  size_t pos_ = 0;
+};
 }  // namespace
 
 TaskGenerator::TaskGenerator(size_t numThreads, TasksQueue &tasks,
                              Logger &logger, size_t max_tasks_num,
-                             std::atomic_int &task_counter)
+                             size_t batch_size, TaskStats &stats,
+                             const LoadProfile &load,
+                             LatencyHistogram &latency)
     : tasks_(tasks),
       logger_(logger),
-      gen_tasks_(0),
-      task_counter_(task_counter),
+      latency_(latency),
+      start_time_(Clock::now()),
+      stats_(stats),
       max_tasks_num_(max_tasks_num == 0 ? std::numeric_limits<size_t>::max()
-                                        : max_tasks_num) {
+                                        : max_tasks_num),
+      batch_size_(std::max<size_t>(batch_size, 1)),
+      next_task_(0) {
   for (size_t i = 0; i < numThreads; ++i) {
-    threads_.emplace_back([this] {
+    threads_.emplace_back([this, load, numThreads, i] {
 #ifdef LOCK_FREE
       tasks_.RegisterThread();
 #endif
-      while (gen_tasks_ < max_tasks_num_) {
-        size_t tnum = gen_tasks_++;
-        auto ts = std::chrono::high_resolution_clock::now();
-        const int sleep_time = rand() % 8;
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+      // With kCallerRuns tasks run here and log from this thread too.
+      logger_.RegisterThread();
+      ArrivalSchedule schedule(load, numThreads, i);
+      size_t next = 0;
+      size_t end = 0;
+      while (true) {
+        if (next == end) {
+          next = next_task_.fetch_add(batch_size_);
+          if (next >= max_tasks_num_) {
+            break;
+          }
+          end = std::min(next + batch_size_, max_tasks_num_);
+        }
+        size_t tnum = next++;
+        Clock::time_point intended_time;
+        if (load.mode == LoadMode::kClosed) {
+          const int sleep_time = rand() % 8;
+          std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+          intended_time = Clock::now();
+        } else {
+          // If we are already behind schedule, send immediately and keep
+          // the intended time: the delay is part of the measured latency.
+          intended_time = start_time_ + schedule.Next();
+          std::this_thread::sleep_until(intended_time);
+        }
 
         double a = static_cast<double>(rand()) / RAND_MAX;
         double b = static_cast<double>(rand()) / RAND_MAX;
-        AddTask([this, a, b, tnum] {
-          ++task_counter_;
+        AddTask([this, a, b, tnum, intended_time] {
+          stats_.completed.Add();
 
           auto ts = std::chrono::high_resolution_clock::now();
           const int sleep_time = rand() % 100;
@@ -55,22 +131,28 @@ TaskGenerator::TaskGenerator(size_t numThreads, TasksQueue &tasks,
           auto te = std::chrono::high_resolution_clock::now();
 
           std::chrono::duration<double, std::milli> ms_double = te - ts;
+          stats_.results.Add(result);
+          if (stats_.keep_outputs) {
+            stats_.outputs.PushBack({tnum, a, b, result});
+          }
 
-          std::unique_ptr<LogMessage> log_message(new LogMessage);
-          log_message->set_time();
-          log_message->fname = __FILE__;
-          log_message->line_num = __LINE__;
-          log_message->smsg << "a: " << a << ", b: " << b << ", num: " << tnum
-                            << ", result: " << result
-                            << ", execution time: " << ms_double;
+          LOG(logger_, kInfo,
+              "a: {}, b: {}, num: {}, result: {}, execution time: {}ms", a, b,
+              tnum, result, ms_double.count());
 
-          logger_.AddMessage(std::move(log_message));
+          latency_.Record(Clock::now() - intended_time);
         });
+        gen_tasks_.Add();
+        LOG(logger_, kDebug, "task issued, num: {}", tnum);
 
         if (need_stop_) {
           break;
         }
       }
+      logger_.UnregisterThread();
+#ifdef LOCK_FREE
+      tasks_.UnregisterThread();
+#endif
     });
   }
 }
@@ -1,30 +1,53 @@
 #include "thread_pool.h"
 
-ThreadPool::ThreadPool(TasksQueue &tasks, LoggerQueue &logger_queue, size_t numThreads)
-    : tasks_(tasks), logger_queue_(logger_queue), need_stop_(false) {
-  for (size_t i = 0; i < numThreads; ++i) {
-    threads_.emplace_back([this, i] {
-#ifdef LOCK_FREE
-      logger_queue_.RegisterThread();
-      tasks_.RegisterThread();
-#endif
-      while (true) {
-        std::function<void()> task;
+#include <algorithm>
+
+#include "logger.h"
+
+namespace {
+// Controller period and how many consecutive backlogged periods are needed
+// before a worker is added. Workers are only retired after a full
+// idle_timeout without tasks, so short dips do not cause spawn/retire thrash.
+constexpr std::chrono::milliseconds kControllerTick(10);
+constexpr size_t kGrowTicks = 3;
+
 #ifdef LOCK_FREE
-        while (!tasks_.TryDequeue(task)) {
-          if (need_stop_) {
-            return;
-          }
-        }
-#else   // LOCK_FREE
-        if (!tasks_.Dequeue(task)) {
-          return;
-        }
+// Idle elastic workers spin for a while and then sleep with exponential
+// backoff, so a quiet pool does not keep all cores busy.
+constexpr size_t kIdleSpins = 1024;
+constexpr std::chrono::microseconds kMinIdleSleep(50);
+constexpr std::chrono::microseconds kMaxIdleSleep(1000);
 #endif  // LOCK_FREE
-        assert(task);
-        task();
-      }
-    });
+}  // namespace
+
+ThreadPool::ThreadPool(TasksQueue &tasks, LoggerQueue &logger_queue, size_t numThreads)
+    : ThreadPool(tasks, logger_queue, numThreads, numThreads,
+                 std::chrono::milliseconds::max()) {}
+
+ThreadPool::ThreadPool(TasksQueue &tasks, LoggerQueue &logger_queue,
+                       size_t minThreads, size_t maxThreads,
+                       std::chrono::milliseconds idle_timeout)
+    : tasks_(tasks),
+      logger_queue_(logger_queue),
+      min_threads_(minThreads),
+      max_threads_(std::max(minThreads, maxThreads)),
+      idle_timeout_(idle_timeout),
+      elastic_(minThreads < maxThreads),
+      need_stop_(false),
+      live_threads_(0),
+      peak_threads_(0),
+      spawned_threads_(0),
+      retired_threads_(0),
+      idle_threads_(0) {
+  {
+    std::unique_lock<std::mutex> lock(workers_lock_);
+    for (size_t i = 0; i < min_threads_; ++i) {
+      SpawnWorker();
+    }
+  }
+
+  if (elastic_) {
+    controller_ = std::thread([this] { RunController(); });
   }
 }
 
@@ -36,7 +59,151 @@ void ThreadPool::Stop() {
 }
 
 void ThreadPool::Join() {
-  for (std::thread &thread : threads_) {
-    thread.join();
+  if (controller_.joinable()) {
+    controller_.join();
   }
-}
\ No newline at end of file
+
+  std::unique_lock<std::mutex> lock(workers_lock_);
+  for (auto &worker : workers_) {
+    worker->thread.join();
+  }
+  workers_.clear();
+}
+
+// Must be called with workers_lock_ held.
+void ThreadPool::SpawnWorker() {
+  size_t live = ++live_threads_;
+  ++spawned_threads_;
+
+  size_t peak = peak_threads_;
+  while (peak < live && !peak_threads_.compare_exchange_weak(peak, live)) {
+  }
+
+  workers_.push_back(std::make_unique<Worker>());
+  Worker *worker = workers_.back().get();
+  worker->thread = std::thread([this, worker] { RunWorker(worker); });
+}
+
+void ThreadPool::RunWorker(Worker *worker) {
+#ifdef LOCK_FREE
+  tasks_.RegisterThread();
+#endif
+  RegisterQueueThread(logger_queue_);
+  std::function<void()> task;
+  while (WaitTask(task)) {
+    assert(task);
+    task();
+    task = nullptr;
+  }
+  UnregisterQueueThread(logger_queue_);
+#ifdef LOCK_FREE
+  tasks_.UnregisterThread();
+#endif
+  worker->finished = true;
+}
+
+// Returns false when the pool is stopped or the worker has been retired.
+bool ThreadPool::WaitTask(std::function<void()> &task) {
+#ifdef LOCK_FREE
+  // As in Logger::Run, the queue is polled once more after the stop flag is
+  // seen, so tasks enqueued right before Stop() are not lost.
+  bool stop = false;
+  if (!elastic_) {
+    while (!tasks_.TryDequeue(task)) {
+      if (stop) {
+        return false;
+      }
+      stop = need_stop_;
+    }
+    return true;
+  }
+
+  size_t spins = 0;
+  auto sleep_time = kMinIdleSleep;
+  std::chrono::steady_clock::time_point idle_since;
+  while (!tasks_.TryDequeue(task)) {
+    if (stop) {
+      if (spins >= kIdleSpins) {
+        --idle_threads_;
+      }
+      return false;
+    }
+    stop = need_stop_;
+    if (++spins < kIdleSpins) {
+      continue;
+    }
+    if (spins == kIdleSpins) {
+      ++idle_threads_;
+      idle_since = std::chrono::steady_clock::now();
+    } else if (std::chrono::steady_clock::now() - idle_since >= idle_timeout_ &&
+               TryRetire()) {
+      --idle_threads_;
+      return false;
+    }
+    std::this_thread::sleep_for(sleep_time);
+    sleep_time = std::min(sleep_time * 2, kMaxIdleSleep);
+  }
+  if (spins >= kIdleSpins) {
+    --idle_threads_;
+  }
+  return true;
+#else   // LOCK_FREE
+  if (!elastic_) {
+    return tasks_.Dequeue(task);
+  }
+
+  while (true) {
+    ++idle_threads_;
+    bool res = tasks_.DequeueFor(task, idle_timeout_);
+    --idle_threads_;
+    if (res) {
+      return true;
+    }
+    if (need_stop_ || TryRetire()) {
+      return false;
+    }
+  }
+#endif  // LOCK_FREE
+}
+
+bool ThreadPool::TryRetire() {
+  size_t live = live_threads_;
+  while (live > min_threads_) {
+    if (live_threads_.compare_exchange_weak(live, live - 1)) {
+      ++retired_threads_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::RunController() {
+  size_t backlog_ticks = 0;
+  while (!need_stop_) {
+    std::this_thread::sleep_for(kControllerTick);
+    ReapWorkers();
+
+    // Backlog: more queued tasks than workers and nobody waiting for work.
+    size_t live = live_threads_;
+    bool backlog = tasks_.Size() > live && idle_threads_ == 0;
+    backlog_ticks = backlog ? backlog_ticks + 1 : 0;
+
+    if (backlog_ticks >= kGrowTicks && live < max_threads_) {
+      std::unique_lock<std::mutex> lock(workers_lock_);
+      SpawnWorker();
+      backlog_ticks = 0;
+    }
+  }
+}
+
+void ThreadPool::ReapWorkers() {
+  std::unique_lock<std::mutex> lock(workers_lock_);
+  for (auto it = workers_.begin(); it != workers_.end();) {
+    if ((*it)->finished) {
+      (*it)->thread.join();
+      it = workers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#include "adaptive_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "queue_test_util.h"
+
+namespace {
+// LinkedQueue asserts its elements are not null.
+typedef std::unique_ptr<int> Item;
+}  // namespace
+
+TEST(AdaptiveQueue, KeepsFifoAcrossSwitches) {
+  AdaptiveQueue<Item> queue(1);
+  queue.RegisterThread();
+  EXPECT_EQ(QueueMode::kLock, queue.Mode());
+
+  for (int i = 0; i < 6; ++i) {
+    queue.Enqueue(std::make_unique<int>(i));
+  }
+  queue.SwitchTo(QueueMode::kLockFree);
+  EXPECT_EQ(QueueMode::kLockFree, queue.Mode());
+  queue.Enqueue(std::make_unique<int>(6));
+
+  Item item;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(item));
+    EXPECT_EQ(i, *item);
+  }
+  queue.SwitchTo(QueueMode::kLock);
+  for (int i = 3; i < 7; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(item));
+    EXPECT_EQ(i, *item);
+  }
+  EXPECT_FALSE(queue.TryDequeue(item));
+
+  ASSERT_EQ(2, queue.GetTransitions().size());
+  EXPECT_EQ(QueueMode::kLockFree, queue.GetTransitions()[0].mode);
+  EXPECT_EQ(QueueMode::kLock, queue.GetTransitions()[1].mode);
+  queue.UnregisterThread();
+}
+
+TEST(AdaptiveQueue, Hysteresis) {
+  AdaptivePolicy policy;
+  policy.window_ops = 16;
+  policy.windows = 3;
+  // Any lock wait is too much, any CAS failure is too many: the queue
+  // moves to lock-free and stays there without contention.
+  policy.max_lock_wait_ns = 0;
+  policy.min_cas_failure_rate = 0;
+  AdaptiveQueue<Item> queue(1, policy);
+  queue.RegisterThread();
+
+  Item item;
+  for (int i = 0; i < 16 * 3 / 2 - 1; ++i) {
+    queue.Enqueue(std::make_unique<int>(i));
+    queue.TryDequeue(item);
+  }
+  EXPECT_EQ(QueueMode::kLock, queue.Mode());
+  queue.Enqueue(std::make_unique<int>(0));
+  queue.TryDequeue(item);
+  EXPECT_EQ(QueueMode::kLockFree, queue.Mode());
+
+  for (int i = 0; i < 1000; ++i) {
+    queue.Enqueue(std::make_unique<int>(i));
+    queue.TryDequeue(item);
+  }
+  EXPECT_EQ(QueueMode::kLockFree, queue.Mode());
+  EXPECT_EQ(1, queue.GetTransitions().size());
+  queue.UnregisterThread();
+}
+
+TEST(AdaptiveQueue, SwitchesUnderLoad) {
+  AdaptivePolicy policy;
+  policy.window_ops = 64;
+  policy.windows = 1;
+  // Both thresholds always hold, so the queue switches every window.
+  policy.max_lock_wait_ns = 0;
+  policy.min_cas_failure_rate = 2;
+  AdaptiveQueue<Item> queue(4, policy);
+
+  ExpectManyToManySum(queue);
+  EXPECT_GT(queue.GetTransitions().size(), 10);
+}
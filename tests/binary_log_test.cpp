@@ -0,0 +1,102 @@
+#include "binary_log.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+constinit LogSite task_site(LogLevel::kInfo, "src/task.cpp", 12,
+                            "a: {}, num: {}, delta: {}, name: {}");
+constinit LogSite plain_site(LogLevel::kWarning, "src/task.cpp", 40,
+                             "no arguments");
+
+std::string Args(double a, size_t num, int delta, const char *name) {
+  std::string args;
+  AppendLogArg(args, a);
+  AppendLogArg(args, num);
+  AppendLogArg(args, delta);
+  AppendLogArg(args, name);
+  return args;
+}
+
+std::string Text(time_t time, const LogSite &site, const std::string &args) {
+  LogTimeFormatter time_formatter;
+  std::string text;
+  EXPECT_TRUE(LogPattern().Format(time_formatter,
+                                  {time, site.GetLevel(), site.GetFile(),
+                                   site.GetLine(), site.GetFormat(), args},
+                                  text));
+  return text;
+}
+}  // namespace
+
+TEST(BinaryLog, FormatsArguments) {
+  LogTimeFormatter time_formatter;
+  std::string text;
+  ASSERT_TRUE(LogPattern("[%l] %m").Format(
+      time_formatter,
+      {0, task_site.GetLevel(), task_site.GetFile(), task_site.GetLine(),
+       task_site.GetFormat(), Args(0.783099123, 300, -7, "x")},
+      text));
+  EXPECT_EQ("[info] a: 0.783099123, num: 300, delta: -7, name: x\n", text);
+}
+
+TEST(BinaryLog, RoundTrip) {
+  struct Written {
+    time_t time;
+    const LogSite *site;
+    std::string args;
+  };
+  std::vector<Written> written = {
+      {1700000000, &task_site, Args(0.5, 1, -1, "first")},
+      {1700000002, &plain_site, ""},
+      // Records may reach the logger slightly out of order.
+      {1700000001, &task_site, Args(-2.25e-9, 1ull << 40, 1 << 20, "")},
+  };
+
+  // Two segments, as a log appended to by two runs.
+  std::string log;
+  std::string record;
+  for (int segment = 0; segment < 2; ++segment) {
+    BinaryLogWriter writer;
+    writer.Begin(record);
+    log += record;
+    for (const Written &w : written) {
+      writer.Write(w.time, *w.site, w.args, record);
+      log += record;
+    }
+  }
+
+  BinaryLogReader reader(log.data(), log.size());
+  BinaryLogReader::Entry entry;
+  std::vector<BinaryLogReader::Site> sites;
+  size_t records = 0;
+  while (reader.Next(entry)) {
+    if (entry.kind == BinaryLogReader::Entry::kSegment) {
+      sites.clear();
+    } else if (entry.kind == BinaryLogReader::Entry::kSite) {
+      ASSERT_EQ(sites.size(), entry.site_id);
+      sites.push_back(entry.site);
+    } else {
+      ASSERT_LT(entry.site_id, sites.size());
+      const Written &w = written[records++ % written.size()];
+      const BinaryLogReader::Site &site = sites[entry.site_id];
+      LogTimeFormatter time_formatter;
+      std::string text;
+      ASSERT_TRUE(LogPattern().Format(time_formatter,
+                                      {entry.time, site.level, site.file,
+                                       site.line, site.format, entry.args},
+                                      text));
+      EXPECT_EQ(Text(w.time, *w.site, w.args), text);
+    }
+  }
+  EXPECT_FALSE(reader.Failed());
+  EXPECT_EQ(2 * written.size(), records);
+
+  // A cut off log is malformed.
+  BinaryLogReader cut(log.data(), log.size() - 1);
+  while (cut.Next(entry)) {
+  }
+  EXPECT_TRUE(cut.Failed());
+}
@@ -0,0 +1,65 @@
+#include "lock/block_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+TEST(BlockQueue, FifoAcrossBlocks) {
+  locks::BlockQueue<int, 4> queue;
+  int value;
+  EXPECT_FALSE(queue.Dequeue(value));
+
+  // Interleaved, so the head block is drained while later ones fill up.
+  int next_in = 0;
+  int next_out = 0;
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 7; ++i) {
+      EXPECT_TRUE(queue.Enqueue(next_in++));
+    }
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_TRUE(queue.Dequeue(value));
+      EXPECT_EQ(next_out++, value);
+    }
+  }
+  EXPECT_EQ(next_in - next_out, queue.Size());
+  while (queue.Dequeue(value)) {
+    EXPECT_EQ(next_out++, value);
+  }
+  EXPECT_EQ(next_in, next_out);
+  EXPECT_TRUE(queue.Empty());
+
+  EXPECT_TRUE(queue.Enqueue(100));
+  ASSERT_TRUE(queue.Dequeue(value));
+  EXPECT_EQ(100, value);
+}
+
+TEST(BlockQueue, DestroysElements) {
+  auto counter = std::make_shared<int>(0);
+  {
+    locks::BlockQueue<std::shared_ptr<int>, 4> queue;
+    for (int i = 0; i < 10; ++i) {
+      queue.Enqueue(std::shared_ptr<int>(counter));
+    }
+    std::shared_ptr<int> value;
+    queue.Dequeue(value);
+    value.reset();
+    EXPECT_EQ(10, counter.use_count());
+  }
+  EXPECT_EQ(1, counter.use_count());
+}
+
+TEST(BlockQueue, Swap) {
+  locks::BlockQueue<int, 4> queue;
+  locks::BlockQueue<int, 4> other;
+  for (int i = 0; i < 6; ++i) {
+    queue.Enqueue(int(i));
+  }
+  queue.Swap(other);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(6, other.Size());
+  int value;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_TRUE(other.Dequeue(value));
+    EXPECT_EQ(i, value);
+  }
+}
@@ -0,0 +1,155 @@
+#include "bounded_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "lock/two_lock_queue.h"
+
+namespace {
+typedef BoundedQueue<locks::TwoLockQueue<int>> IntQueue;
+typedef BoundedQueue<locks::TwoLockQueue<std::unique_ptr<int>>> PtrQueue;
+
+constexpr auto kWait = std::chrono::milliseconds(20);
+
+// Starts a producer that blocks on the full queue and waits until it does.
+std::thread BlockedProducer(IntQueue &queue, int value,
+                            std::atomic_bool &admitted) {
+  std::thread producer([&queue, value, &admitted] {
+    admitted = queue.Enqueue(int(value));
+  });
+  std::this_thread::sleep_for(kWait);
+  return producer;
+}
+}  // namespace
+
+TEST(BoundedQueue, BlockWakesOnDequeue) {
+  IntQueue queue(2, AdmissionPolicy::kBlock);
+  EXPECT_TRUE(queue.Enqueue(1));
+  EXPECT_TRUE(queue.Enqueue(2));
+
+  std::atomic_bool admitted = false;
+  std::thread producer = BlockedProducer(queue, 3, admitted);
+  EXPECT_FALSE(admitted);
+  EXPECT_EQ(0u, queue.GetStats().blocked);
+
+  int value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(1, value);
+  producer.join();
+  EXPECT_TRUE(admitted);
+
+  for (int expected : {2, 3}) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+  EXPECT_EQ(0u, queue.Size());
+
+  const AdmissionStats &stats = queue.GetStats();
+  EXPECT_EQ(1u, stats.blocked);
+  EXPECT_GE(stats.blocked_ns, uint64_t(std::chrono::nanoseconds(kWait).count()));
+  EXPECT_EQ(0u, stats.rejected);
+  EXPECT_EQ(0u, stats.dropped);
+}
+
+TEST(BoundedQueue, BlockWakesOnStop) {
+  IntQueue queue(1, AdmissionPolicy::kBlock);
+  EXPECT_TRUE(queue.Enqueue(1));
+
+  std::atomic_bool admitted = true;
+  std::thread producer = BlockedProducer(queue, 2, admitted);
+  queue.Stop();
+  producer.join();
+  EXPECT_FALSE(admitted);
+
+  // Only the element admitted before the stop is there.
+  int value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(queue.TryDequeue(value));
+  EXPECT_EQ(0u, queue.Size());
+
+  const AdmissionStats &stats = queue.GetStats();
+  EXPECT_EQ(1u, stats.blocked);
+  EXPECT_GT(stats.blocked_ns, 0u);
+  EXPECT_EQ(0u, stats.rejected);
+}
+
+TEST(BoundedQueue, BlockDoesNotWaitWithRoom) {
+  IntQueue queue(2, AdmissionPolicy::kBlock);
+  EXPECT_TRUE(queue.Enqueue(1));
+  EXPECT_TRUE(queue.Enqueue(2));
+  EXPECT_EQ(0u, queue.GetStats().blocked);
+  EXPECT_EQ(0u, queue.GetStats().blocked_ns);
+}
+
+TEST(BoundedQueue, DropOldestEvicts) {
+  IntQueue queue(3, AdmissionPolicy::kDropOldest);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(queue.Enqueue(int(i)));
+    EXPECT_EQ(size_t(std::min(i + 1, 3)), queue.Size());
+  }
+
+  int value;
+  for (int expected : {2, 3, 4}) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+  EXPECT_EQ(0u, queue.Size());
+
+  const AdmissionStats &stats = queue.GetStats();
+  EXPECT_EQ(2u, stats.dropped);
+  EXPECT_EQ(0u, stats.rejected);
+  EXPECT_EQ(0u, stats.blocked);
+}
+
+TEST(BoundedQueue, RejectLeavesData) {
+  PtrQueue queue(1, AdmissionPolicy::kReject);
+  EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(1)));
+
+  auto data = std::make_unique<int>(2);
+  EXPECT_FALSE(queue.Enqueue(std::move(data)));
+  ASSERT_TRUE(data);
+  EXPECT_EQ(2, *data);
+  EXPECT_EQ(1u, queue.Size());
+  EXPECT_EQ(1u, queue.GetStats().rejected);
+}
+
+TEST(BoundedQueue, CallerRunsLeavesData) {
+  PtrQueue queue(2, AdmissionPolicy::kCallerRuns);
+  EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(1)));
+  EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(2)));
+
+  for (int i = 0; i < 3; ++i) {
+    auto data = std::make_unique<int>(3 + i);
+    EXPECT_FALSE(queue.Enqueue(std::move(data)));
+    ASSERT_TRUE(data);
+    EXPECT_EQ(3 + i, *data);
+  }
+  EXPECT_EQ(2u, queue.Size());
+
+  // A freed place admits again.
+  std::unique_ptr<int> value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(1, *value);
+  EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(6)));
+
+  const AdmissionStats &stats = queue.GetStats();
+  EXPECT_EQ(3u, stats.rejected);
+  EXPECT_EQ(0u, stats.dropped);
+  EXPECT_EQ(0u, stats.blocked);
+}
+
+TEST(BoundedQueue, Unbounded) {
+  IntQueue queue(0, AdmissionPolicy::kReject);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(queue.Enqueue(int(i)));
+  }
+  EXPECT_EQ(1000u, queue.Size());
+  EXPECT_EQ(0u, queue.GetStats().rejected);
+}
@@ -0,0 +1,186 @@
+#include "lock-free/bounded_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "queue_test_util.h"
+
+namespace {
+using lock_free::BoundedRing;
+using lock_free::Consumers;
+using lock_free::Producers;
+
+template <typename Ring>
+class BoundedRingTopology : public ::testing::Test {};
+
+typedef ::testing::Types<
+    BoundedRing<int, Producers::kSingle, Consumers::kSingle>,
+    BoundedRing<int, Producers::kMulti, Consumers::kSingle>,
+    BoundedRing<int, Producers::kSingle, Consumers::kMulti>,
+    BoundedRing<int, Producers::kMulti, Consumers::kMulti>,
+    BoundedRing<int, Producers::kSingle, Consumers::kSingle, 4>,
+    BoundedRing<int, Producers::kMulti, Consumers::kMulti, 4>>
+    Topologies;
+}  // namespace
+
+TYPED_TEST_SUITE(BoundedRingTopology, Topologies);
+
+TYPED_TEST(BoundedRingTopology, FifoAndFull) {
+  TypeParam ring(4);
+  int value;
+  EXPECT_FALSE(ring.TryDequeue(value));
+
+  // Several laps, so positions wrap around the slots.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(ring.Enqueue(lap * 4 + i));
+    }
+    EXPECT_FALSE(ring.Enqueue(-1));
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(ring.TryDequeue(value));
+      EXPECT_EQ(lap * 4 + i, value);
+    }
+    EXPECT_FALSE(ring.TryDequeue(value));
+  }
+}
+
+TYPED_TEST(BoundedRingTopology, HandOff) {
+  const int kItems = 100000;
+  TypeParam ring(4);
+
+  std::thread producer([&ring] {
+    for (int i = 0; i < kItems; ++i) {
+      while (!ring.Enqueue(int(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int value;
+  for (int i = 0; i < kItems; ++i) {
+    while (!ring.TryDequeue(value)) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(i, value);
+  }
+  producer.join();
+}
+
+TYPED_TEST(BoundedRingTopology, ClaimInPlace) {
+  TypeParam ring(4);
+  EXPECT_TRUE(ring.Emplace(1));
+
+  size_t write_pos;
+  int *slot = ring.ClaimWrite(write_pos);
+  ASSERT_NE(nullptr, slot);
+  *slot = 2;
+
+  size_t read_pos;
+  int *first = ring.ClaimRead(read_pos);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(1, *first);
+  ring.Release(read_pos);
+
+  // Not visible until it is committed.
+  int value;
+  EXPECT_FALSE(ring.TryDequeue(value));
+  ring.Commit(write_pos);
+  ASSERT_TRUE(ring.TryDequeue(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(nullptr, ring.ClaimRead(read_pos));
+}
+
+TEST(BoundedRing, ClaimThroughBoundedQueue) {
+  typedef BoundedRing<std::string, Producers::kSingle, Consumers::kSingle>
+      Ring;
+  BoundedQueue<Ring> queue(2, AdmissionPolicy::kReject);
+
+  size_t pos;
+  std::string *slot = queue.ClaimWrite(pos);
+  ASSERT_NE(nullptr, slot);
+  slot->assign("first");
+  queue.Commit(pos);
+  EXPECT_TRUE(queue.Emplace(3, 'x'));
+  EXPECT_EQ(nullptr, queue.ClaimWrite(pos));
+  EXPECT_FALSE(queue.Emplace("rejected"));
+  EXPECT_EQ(2, queue.Size());
+
+  slot = queue.ClaimRead(pos);
+  ASSERT_NE(nullptr, slot);
+  EXPECT_EQ("first", *slot);
+  queue.Release(pos);
+  EXPECT_EQ(1, queue.Size());
+
+  std::string value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ("xxx", value);
+  EXPECT_EQ(0, queue.Size());
+}
+
+// A consumer still holding the oldest slot keeps the ring full after
+// another consumer has freed a place in the queue: the admitted element
+// must wait for the slot instead of being dropped.
+TEST(BoundedRing, AdmittedElementWaitsForHeldSlot) {
+  typedef BoundedRing<int, Producers::kMulti, Consumers::kMulti> Ring;
+  BoundedQueue<Ring> queue(2, AdmissionPolicy::kBlock);
+  ASSERT_TRUE(queue.Enqueue(1));
+  ASSERT_TRUE(queue.Enqueue(2));
+
+  size_t held_pos;
+  ASSERT_NE(nullptr, queue.ClaimRead(held_pos));
+  int value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(2, value);
+
+  std::atomic_bool enqueued = false;
+  std::thread producer([&] {
+    EXPECT_TRUE(queue.Enqueue(3));
+    enqueued = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(enqueued);
+  queue.Release(held_pos);
+  producer.join();
+
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(0, queue.Size());
+  EXPECT_EQ(0, queue.GetStats().rejected);
+
+  // Stop() lets a waiting element go.
+  ASSERT_TRUE(queue.Enqueue(4));
+  ASSERT_TRUE(queue.Enqueue(5));
+  ASSERT_NE(nullptr, queue.ClaimRead(held_pos));
+  ASSERT_TRUE(queue.TryDequeue(value));
+  std::thread stopped([&] { EXPECT_FALSE(queue.Enqueue(6)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.Stop();
+  stopped.join();
+  EXPECT_EQ(1, queue.Size());
+  queue.Release(held_pos);
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST(BoundedRing, StaticCapacity) {
+  BoundedRing<int, Producers::kSingle, Consumers::kSingle, 8> ring;
+  EXPECT_EQ(8, ring.Capacity());
+
+  // A smaller requested capacity only limits BoundedQueue, the ring keeps
+  // its static one.
+  BoundedRing<int, Producers::kMulti, Consumers::kSingle, 8> smaller(4);
+  EXPECT_EQ(8, smaller.Capacity());
+
+  typedef BoundedRing<int, Producers::kMulti, Consumers::kMulti, 8> Ring;
+  EXPECT_THROW(Ring ring(16), std::invalid_argument);
+  EXPECT_THROW(Ring ring(0), std::invalid_argument);
+}
+
+TEST(BoundedRing, ManyToMany) {
+  BoundedRing<int, Producers::kMulti, Consumers::kMulti> ring(16);
+  ExpectManyToManySum(ring);
+}
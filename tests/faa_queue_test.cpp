@@ -0,0 +1,100 @@
+#include "lock-free/faa_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(FaaArrayQueue, Fifo) {
+  lock_free::FaaArrayQueue<std::unique_ptr<int>, 4> queue(1);
+  queue.RegisterThread();
+
+  std::unique_ptr<int> value;
+  EXPECT_FALSE(queue.TryDequeue(value));
+
+  // Spans several segments.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(i)));
+  }
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+
+  queue.UnregisterThread();
+}
+
+TEST(FaaArrayQueue, DestroysLeftElements) {
+  auto counter = std::make_shared<int>(0);
+  {
+    lock_free::FaaArrayQueue<std::shared_ptr<int>, 4> queue(1);
+    queue.RegisterThread();
+    for (int i = 0; i < 10; ++i) {
+      queue.Enqueue(std::shared_ptr<int>(counter));
+    }
+    std::shared_ptr<int> value;
+    queue.TryDequeue(value);
+    queue.UnregisterThread();
+  }
+  EXPECT_EQ(1, counter.use_count());
+}
+
+TEST(FaaArrayQueue, RecyclesSegments) {
+  lock_free::FaaArrayQueue<std::unique_ptr<int>, 4> queue(1);
+  queue.RegisterThread();
+
+  // 1000 segments go through the queue, a few of them at a time.
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 4000; i += 8) {
+    for (int j = i; j < i + 8; ++j) {
+      queue.Enqueue(std::make_unique<int>(j));
+    }
+    for (int j = i; j < i + 8; ++j) {
+      ASSERT_TRUE(queue.TryDequeue(value));
+      EXPECT_EQ(j, *value);
+    }
+  }
+  // Retired segments wait for a scan before they come back, 18 at a time
+  // with one thread.
+  EXPECT_LT(queue.GetSegmentsAllocated(), 50u);
+
+  queue.UnregisterThread();
+}
+
+TEST(FaaArrayQueue, ConcurrentProducersConsumers) {
+  const int kThreads = 4;
+  const int kPerThread = 20000;
+  lock_free::FaaArrayQueue<std::unique_ptr<int>, 64> queue(2 * kThreads);
+
+  std::atomic_long sum = 0;
+  std::atomic_int consumed = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      queue.RegisterThread();
+      for (int i = 1; i <= kPerThread; ++i) {
+        queue.Enqueue(std::make_unique<int>(i));
+      }
+      queue.UnregisterThread();
+    });
+    threads.emplace_back([&] {
+      queue.RegisterThread();
+      std::unique_ptr<int> value;
+      while (consumed < kThreads * kPerThread) {
+        if (queue.TryDequeue(value)) {
+          sum += *value;
+          ++consumed;
+        }
+      }
+      queue.UnregisterThread();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(kThreads * kPerThread, consumed);
+  EXPECT_EQ(static_cast<long>(kThreads) * kPerThread * (kPerThread + 1) / 2,
+            sum);
+}
@@ -0,0 +1,61 @@
+#include "lock/flat_combining_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(FlatCombiningQueue, Fifo) {
+  locks::FlatCombiningQueue<std::unique_ptr<int>> queue;
+  queue.RegisterThread();
+
+  std::unique_ptr<int> value;
+  EXPECT_FALSE(queue.TryDequeue(value));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(i)));
+  }
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+
+  queue.UnregisterThread();
+}
+
+TEST(FlatCombiningQueue, ConcurrentProducersConsumers) {
+  const int kThreads = 4;
+  const int kPerThread = 10000;
+  locks::FlatCombiningQueue<int> queue;
+
+  std::atomic_long sum = 0;
+  std::atomic_int consumed = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      queue.RegisterThread();
+      for (int i = 1; i <= kPerThread; ++i) {
+        queue.Enqueue(std::move(i));
+      }
+      queue.UnregisterThread();
+    });
+    threads.emplace_back([&] {
+      queue.RegisterThread();
+      int value;
+      while (consumed < kThreads * kPerThread) {
+        if (queue.TryDequeue(value)) {
+          sum += value;
+          ++consumed;
+        }
+      }
+      queue.UnregisterThread();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(static_cast<long>(kThreads) * kPerThread * (kPerThread + 1) / 2,
+            sum);
+}
@@ -0,0 +1,163 @@
+#include "lock-free/hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST(HashMap, FindInsertErase) {
+  lock_free::HashMap<uint64_t, int> map(1);
+  map.RegisterThread();
+
+  int value;
+  EXPECT_FALSE(map.Find(1, value));
+  EXPECT_TRUE(map.InsertOrAssign(1, 10));
+  EXPECT_FALSE(map.InsertOrAssign(1, 11));
+  ASSERT_TRUE(map.Find(1, value));
+  EXPECT_EQ(11, value);
+  EXPECT_EQ(1, map.Size());
+
+  EXPECT_TRUE(map.Erase(1));
+  EXPECT_FALSE(map.Erase(1));
+  EXPECT_FALSE(map.Find(1, value));
+  EXPECT_TRUE(map.InsertOrAssign(1, 12));
+  ASSERT_TRUE(map.Find(1, value));
+  EXPECT_EQ(12, value);
+
+  map.UnregisterThread();
+}
+
+TEST(HashMap, Grows) {
+  const uint64_t kKeys = 10000;
+  lock_free::HashMap<uint64_t, uint64_t> map(1);
+  map.RegisterThread();
+
+  for (uint64_t key = 0; key < kKeys; ++key) {
+    EXPECT_TRUE(map.InsertOrAssign(key, key * 2));
+  }
+  EXPECT_GE(map.Capacity(), kKeys);
+  EXPECT_EQ(kKeys, map.Size());
+
+  uint64_t value;
+  for (uint64_t key = 0; key < kKeys; ++key) {
+    ASSERT_TRUE(map.Find(key, value));
+    EXPECT_EQ(key * 2, value);
+  }
+
+  size_t seen = 0;
+  map.ForEach([&seen](uint64_t key, uint64_t value) {
+    EXPECT_EQ(key * 2, value);
+    ++seen;
+  });
+  EXPECT_EQ(kKeys, seen);
+
+  map.UnregisterThread();
+}
+
+TEST(HashMap, TombstonesAreDropped) {
+  lock_free::HashMap<uint64_t, int> map(1, 64);
+  map.RegisterThread();
+
+  // Churn through many more keys than slots while keeping few live, the
+  // table is rehashed in place instead of growing.
+  for (uint64_t key = 0; key < 10000; ++key) {
+    map.InsertOrAssign(key, 0);
+    if (key >= 4) {
+      EXPECT_TRUE(map.Erase(key - 4));
+    }
+  }
+  EXPECT_EQ(4, map.Size());
+  EXPECT_EQ(64, map.Capacity());
+
+  map.UnregisterThread();
+}
+
+TEST(HashMap, ConcurrentWriters) {
+  const int kThreads = 4;
+  const uint64_t kPerThread = 5000;
+  lock_free::HashMap<uint64_t, uint64_t> map(kThreads + 1);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&map, t] {
+      map.RegisterThread();
+      uint64_t first = t * kPerThread;
+      for (uint64_t key = first; key < first + kPerThread; ++key) {
+        map.InsertOrAssign(key, key);
+      }
+      // Erase the odd keys and overwrite the even ones while the others
+      // are still inserting and resizing.
+      uint64_t value;
+      for (uint64_t key = first; key < first + kPerThread; ++key) {
+        if (key % 2 == 1) {
+          EXPECT_TRUE(map.Erase(key));
+        } else {
+          EXPECT_FALSE(map.InsertOrAssign(key, key + 1));
+        }
+        map.Find(key ^ 1, value);
+      }
+      map.ForEach([](uint64_t, uint64_t) {});
+      map.UnregisterThread();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  map.RegisterThread();
+  EXPECT_EQ(kThreads * kPerThread / 2, map.Size());
+  uint64_t value;
+  for (uint64_t key = 0; key < kThreads * kPerThread; ++key) {
+    if (key % 2 == 1) {
+      EXPECT_FALSE(map.Find(key, value));
+    } else {
+      ASSERT_TRUE(map.Find(key, value));
+      EXPECT_EQ(key + 1, value);
+    }
+  }
+  map.UnregisterThread();
+}
+
+// Many migrations while threads are preempted in the middle of copying
+// chunks, which the others then copy again instead of waiting.
+TEST(HashMap, ConcurrentChurn) {
+  const int kThreads = 4;
+  const uint64_t kPerThread = 20000;
+  const uint64_t kLive = 8;
+  lock_free::HashMap<uint64_t, uint64_t> map(kThreads + 1, 1024);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&map, t] {
+      map.RegisterThread();
+      uint64_t first = t * kPerThread;
+      uint64_t value;
+      for (uint64_t key = first; key < first + kPerThread; ++key) {
+        EXPECT_TRUE(map.InsertOrAssign(key, key));
+        if (key >= first + kLive) {
+          EXPECT_TRUE(map.Erase(key - kLive));
+          EXPECT_FALSE(map.Find(key - kLive, value));
+        }
+        ASSERT_TRUE(map.Find(key, value));
+        EXPECT_EQ(key, value);
+      }
+      map.UnregisterThread();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  map.RegisterThread();
+  EXPECT_EQ(kThreads * kLive, map.Size());
+  EXPECT_EQ(1024, map.Capacity());
+  size_t entries = 0;
+  map.ForEach([&](uint64_t key, uint64_t value) {
+    EXPECT_EQ(key, value);
+    EXPECT_GE(key % kPerThread, kPerThread - kLive);
+    ++entries;
+  });
+  EXPECT_EQ(kThreads * kLive, entries);
+  map.UnregisterThread();
+}
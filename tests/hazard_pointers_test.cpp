@@ -0,0 +1,83 @@
+#include "lock-free/hazard_pointers.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+struct Node {
+  static std::atomic_int alive;
+
+  Node(bool *deleted = nullptr) : deleted(deleted) { ++alive; }
+  ~Node() {
+    --alive;
+    if (deleted != nullptr) {
+      *deleted = true;
+    }
+  }
+
+  bool *deleted;
+};
+
+std::atomic_int Node::alive = 0;
+}  // namespace
+
+TEST(HazardPointers, RetireFreesUnprotectedNodes) {
+  {
+    lock_free::HazardPointers<Node> hp(1);
+    hp.AddThread();
+    for (int i = 0; i < 1000; ++i) {
+      hp.Retire(new Node);
+    }
+    // Scans run every 2 * H + 16 retirements.
+    EXPECT_LT(Node::alive, 100);
+    hp.RemoveThread();
+  }
+  EXPECT_EQ(0, Node::alive);
+}
+
+TEST(HazardPointers, ProtectedNodeSurvivesScan) {
+  lock_free::HazardPointers<Node> hp(1);
+  hp.AddThread();
+
+  bool deleted = false;
+  Node *node = new Node(&deleted);
+  hp.AcquireHazardPointer(0, node);
+  hp.Retire(node);
+  for (int i = 0; i < 1000; ++i) {
+    hp.Retire(new Node);
+  }
+  EXPECT_FALSE(deleted);
+
+  hp.ReleaseHazardPointer(0);
+  for (int i = 0; i < 1000; ++i) {
+    hp.Retire(new Node);
+  }
+  EXPECT_TRUE(deleted);
+  hp.RemoveThread();
+}
+
+TEST(HazardPointers, OrphansAreAdopted) {
+  lock_free::HazardPointers<Node> hp(2);
+
+  Node *node = new Node;
+  std::thread guard([&] {
+    hp.AddThread();
+    hp.AcquireHazardPointer(0, node);
+    std::thread retirer([&] {
+      hp.AddThread();
+      hp.Retire(node);
+      // Exits while the node is still protected: it becomes an orphan.
+      hp.RemoveThread();
+    });
+    retirer.join();
+    EXPECT_EQ(1, Node::alive);
+    hp.ReleaseHazardPointer(0);
+
+    for (int i = 0; i < 1000; ++i) {
+      hp.Retire(new Node);
+    }
+    hp.RemoveThread();
+  });
+  guard.join();
+
+  EXPECT_EQ(0, Node::alive);
+}
@@ -0,0 +1,131 @@
+#include "latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+using std::chrono::nanoseconds;
+
+constexpr int64_t kMaxValue = std::numeric_limits<int64_t>::max();
+
+// Upper bound of the bucket holding v: a larger value keeps Percentile from
+// clipping it to the maximum.
+int64_t BucketUpperBound(int64_t v) {
+  LatencyHistogram histogram;
+  histogram.Record(nanoseconds(v));
+  histogram.Record(nanoseconds(kMaxValue));
+  return histogram.Percentile(0).count();
+}
+}  // namespace
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.Count());
+  EXPECT_EQ(nanoseconds(0), histogram.Mean());
+  EXPECT_EQ(nanoseconds(0), histogram.Max());
+  EXPECT_EQ(nanoseconds(0), histogram.Percentile(0.5));
+}
+
+TEST(LatencyHistogram, ExactBelowSubBuckets) {
+  for (int64_t v = 0; v < 32; ++v) {
+    EXPECT_EQ(v, BucketUpperBound(v));
+  }
+}
+
+TEST(LatencyHistogram, BucketBoundaries) {
+  // From 32 on every power of two is split into 16 buckets.
+  EXPECT_EQ(33, BucketUpperBound(32));
+  EXPECT_EQ(33, BucketUpperBound(33));
+  EXPECT_EQ(35, BucketUpperBound(34));
+  EXPECT_EQ(63, BucketUpperBound(62));
+  EXPECT_EQ(63, BucketUpperBound(63));
+  EXPECT_EQ(67, BucketUpperBound(64));
+  EXPECT_EQ(67, BucketUpperBound(67));
+  EXPECT_EQ(71, BucketUpperBound(68));
+  EXPECT_EQ(1087, BucketUpperBound(1024));
+  EXPECT_EQ(1087, BucketUpperBound(1087));
+  EXPECT_EQ(1151, BucketUpperBound(1088));
+}
+
+TEST(LatencyHistogram, RelativeError) {
+  for (int64_t v = 1; v < (int64_t(1) << 40); v = v * 3 / 2 + 1) {
+    int64_t bound = BucketUpperBound(v);
+    EXPECT_GE(bound, v);
+    EXPECT_LE(bound - v, v / 16) << v;
+  }
+}
+
+TEST(LatencyHistogram, ZeroAndMaxValues) {
+  LatencyHistogram histogram;
+  histogram.Record(nanoseconds(0));
+  EXPECT_EQ(nanoseconds(0), histogram.Percentile(0.5));
+  EXPECT_EQ(nanoseconds(0), histogram.Max());
+
+  // Negative latencies (clock skew) count as zero.
+  histogram.Record(nanoseconds(-5));
+  EXPECT_EQ(2u, histogram.Count());
+  EXPECT_EQ(nanoseconds(0), histogram.Percentile(1));
+
+  // The last bucket ends exactly at the largest value.
+  histogram.Record(nanoseconds(kMaxValue));
+  EXPECT_EQ(nanoseconds(kMaxValue), histogram.Max());
+  EXPECT_EQ(nanoseconds(kMaxValue), histogram.Percentile(1));
+  EXPECT_EQ(kMaxValue, BucketUpperBound(kMaxValue - 1));
+  EXPECT_EQ(nanoseconds(0), histogram.Percentile(0.5));
+}
+
+TEST(LatencyHistogram, PercentilesOfUniformDistribution) {
+  LatencyHistogram histogram;
+  for (int64_t v = 1; v <= 10000; ++v) {
+    histogram.Record(nanoseconds(v));
+  }
+  EXPECT_EQ(10000u, histogram.Count());
+  EXPECT_EQ(nanoseconds(5000), histogram.Mean());
+  EXPECT_EQ(nanoseconds(10000), histogram.Max());
+
+  // Upper bounds of the buckets holding the 5000th value, [4864, 5119],
+  // and the 9900th one, [9728, 10239] clipped to the maximum.
+  EXPECT_EQ(nanoseconds(5119), histogram.Percentile(0.5));
+  EXPECT_EQ(nanoseconds(10000), histogram.Percentile(0.99));
+  EXPECT_EQ(nanoseconds(10000), histogram.Percentile(1));
+}
+
+TEST(LatencyHistogram, PercentilesOfTwoModes) {
+  LatencyHistogram histogram;
+  // 90% fast, 10% slow.
+  for (int i = 0; i < 900; ++i) {
+    histogram.Record(nanoseconds(10));
+  }
+  for (int i = 0; i < 100; ++i) {
+    histogram.Record(nanoseconds(1000000));
+  }
+  EXPECT_EQ(nanoseconds(10), histogram.Percentile(0.5));
+  EXPECT_EQ(nanoseconds(10), histogram.Percentile(0.9));
+  EXPECT_EQ(nanoseconds(1000000), histogram.Percentile(0.91));
+  EXPECT_EQ(nanoseconds(1000000), histogram.Percentile(0.99));
+}
+
+TEST(LatencyHistogram, ConcurrentRecords) {
+  const int kThreads = 4;
+  const int kPerThread = 10000;
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&histogram] {
+      for (int i = 1; i <= kPerThread; ++i) {
+        histogram.Record(nanoseconds(i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(uint64_t(kThreads) * kPerThread, histogram.Count());
+  EXPECT_EQ(nanoseconds(kPerThread), histogram.Max());
+  EXPECT_EQ(nanoseconds((kPerThread + 1) / 2), histogram.Mean());
+}
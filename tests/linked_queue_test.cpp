@@ -0,0 +1,25 @@
+#include "lock-free/linked_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+// Elements of any type, default constructed ones included, can be
+// emplaced; only Enqueue requires a non-null element.
+TEST(LinkedQueue, Emplace) {
+  lock_free::LinkedQueue<std::pair<int, std::string>> queue(1);
+  queue.RegisterThread();
+  EXPECT_TRUE(queue.Emplace());
+  EXPECT_TRUE(queue.Emplace(2, "two"));
+
+  std::pair<int, std::string> value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(0, value.first);
+  EXPECT_EQ("", value.second);
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(2, value.first);
+  EXPECT_EQ("two", value.second);
+  EXPECT_FALSE(queue.TryDequeue(value));
+  queue.UnregisterThread();
+}
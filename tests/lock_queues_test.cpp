@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lock/linked_queue.h"
+#include "lock/lock_policies.h"
+#include "lock/two_lock_queue.h"
+
+TEST(TwoLockQueue, Fifo) {
+  locks::TwoLockQueue<std::unique_ptr<int>> queue;
+  std::unique_ptr<int> value;
+  EXPECT_FALSE(queue.TryDequeue(value));
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::make_unique<int>(i)));
+  }
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+}
+
+TEST(TwoLockQueue, Emplace) {
+  locks::TwoLockQueue<std::pair<int, std::unique_ptr<int>>> queue;
+  EXPECT_TRUE(queue.Emplace(1, std::make_unique<int>(2)));
+
+  std::pair<int, std::unique_ptr<int>> value;
+  ASSERT_TRUE(queue.TryDequeue(value));
+  EXPECT_EQ(1, value.first);
+  EXPECT_EQ(2, *value.second);
+}
+
+TEST(TwoLockQueue, StopWakesConsumers) {
+  locks::TwoLockQueue<int> queue;
+  EXPECT_TRUE(queue.Enqueue(1));
+
+  std::thread consumer([&queue] {
+    int value = 0;
+    EXPECT_TRUE(queue.Dequeue(value));
+    EXPECT_EQ(1, value);
+    EXPECT_FALSE(queue.Dequeue(value));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.Stop();
+  consumer.join();
+
+  EXPECT_FALSE(queue.Enqueue(2));
+}
+
+TEST(TwoLockQueue, BlockedConsumersGetAllElements) {
+  const int kThreads = 4;
+  const int kPerThread = 10000;
+  locks::TwoLockQueue<int> queue;
+
+  std::atomic_long sum = 0;
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; ++t) {
+    consumers.emplace_back([&] {
+      int value;
+      while (queue.Dequeue(value)) {
+        sum += value;
+      }
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&] {
+      for (int i = 1; i <= kPerThread; ++i) {
+        queue.Enqueue(std::move(i));
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  // Dequeue drains what is left after Stop before returning false.
+  queue.Stop();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+
+  EXPECT_EQ(static_cast<long>(kThreads) * kPerThread * (kPerThread + 1) / 2,
+            sum);
+}
+
+TEST(LinkedQueueThreadSafe, DequeueAll) {
+  locks::LinkedQueueThreadSafe<int> queue;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::move(i)));
+  }
+
+  locks::BlockQueue<int> batch;
+  ASSERT_TRUE(queue.DequeueAll(batch));
+  EXPECT_EQ(3, batch.Size());
+  int value;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(batch.Dequeue(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(value));
+
+  queue.Stop();
+  EXPECT_FALSE(queue.DequeueAll(batch));
+  EXPECT_FALSE(queue.Emplace(3));
+}
+
+template <typename Lock>
+class LockPolicy : public ::testing::Test {};
+
+typedef ::testing::Types<locks::MutexLock, locks::TtasLock, locks::TicketLock,
+                         locks::McsLock, locks::SpinFutexLock>
+    LockPolicies;
+TYPED_TEST_SUITE(LockPolicy, LockPolicies);
+
+TYPED_TEST(LockPolicy, MutualExclusion) {
+  const int kThreads = 4;
+  const int kPerThread = 20000;
+  TypeParam lock;
+  long counter = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kPerThread; ++i) {
+        std::unique_lock<TypeParam> guard(lock);
+        ++counter;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(kThreads * kPerThread, counter);
+  EXPECT_EQ(kThreads * kPerThread, lock.GetStats().GetAcquisitions());
+  EXPECT_TRUE(lock.try_lock());
+  EXPECT_FALSE(lock.try_lock());
+  lock.unlock();
+}
+
+TYPED_TEST(LockPolicy, QueueWithConditionVariable) {
+  locks::LinkedQueueThreadSafe<int, TypeParam> queue;
+  std::thread consumer([&queue] {
+    int value = 0;
+    long sum = 0;
+    while (queue.Dequeue(value)) {
+      sum += value;
+    }
+    EXPECT_EQ(1000 * 1001 / 2, sum);
+  });
+  for (int i = 1; i <= 1000; ++i) {
+    queue.Enqueue(std::move(i));
+  }
+  queue.Stop();
+  consumer.join();
+}
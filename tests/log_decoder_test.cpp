@@ -0,0 +1,90 @@
+#include "log_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+constinit LogSite num_site(LogLevel::kInfo, "src/task.cpp", 12,
+                           "num: {}");
+
+const LogPattern pattern("%l %m");
+
+// A segment of `records` records of num_site, numbered from 0; offsets
+// gets where each record starts.
+std::string Log(int records, std::vector<size_t> *offsets = nullptr) {
+  std::string log;
+  std::string record;
+  BinaryLogWriter writer;
+  writer.Begin(record);
+  log += record;
+  for (int i = 0; i < records; ++i) {
+    std::string args;
+    AppendLogArg(args, i);
+    writer.Write(1700000000, num_site, args, record);
+    if (offsets != nullptr) {
+      offsets->push_back(log.size());
+    }
+    log += record;
+  }
+  return log;
+}
+
+std::string Text(int begin, int end) {
+  std::string text;
+  for (int i = begin; i < end; ++i) {
+    text += "info num: " + std::to_string(i) + "\n";
+  }
+  return text;
+}
+}  // namespace
+
+// Small blocks split over more threads than some blocks have records.
+TEST(LogDecoder, DecodesInBlocks) {
+  std::string log = Log(23);
+  std::ostringstream out;
+  LogDecoder decoder(pattern, out, 3, 2);
+  EXPECT_TRUE(decoder.Decode(log.data(), log.size()));
+  EXPECT_EQ(Text(0, 23), out.str());
+  EXPECT_EQ(23u, decoder.GetRecords());
+  EXPECT_EQ(0u, decoder.GetMalformed());
+}
+
+// The records read before a malformed entry are written out.
+TEST(LogDecoder, WritesRecordsBeforeUnknownSite) {
+  std::vector<size_t> offsets;
+  std::string log = Log(10, &offsets);
+  // Size, kind and time delta of the 8th record, then its site id.
+  log[offsets[7] + 3] = 5;
+
+  std::ostringstream out;
+  LogDecoder decoder(pattern, out, 2, 4);
+  EXPECT_FALSE(decoder.Decode(log.data(), log.size()));
+  EXPECT_EQ(Text(0, 7), out.str());
+  EXPECT_EQ(7u, decoder.GetRecords());
+}
+
+TEST(LogDecoder, WritesRecordsBeforeCutOff) {
+  std::string log = Log(10);
+  std::ostringstream out;
+  LogDecoder decoder(pattern, out, 2);
+  EXPECT_FALSE(decoder.Decode(log.data(), log.size() - 1));
+  EXPECT_EQ(Text(0, 9), out.str());
+  EXPECT_EQ(9u, decoder.GetRecords());
+}
+
+TEST(LogDecoder, CountsMalformedArguments) {
+  std::vector<size_t> offsets;
+  std::string log = Log(3, &offsets);
+  // The argument type byte of the 2nd record.
+  log[offsets[1] + 4] = 9;
+
+  std::ostringstream out;
+  LogDecoder decoder(pattern, out, 1);
+  EXPECT_TRUE(decoder.Decode(log.data(), log.size()));
+  EXPECT_EQ(3u, decoder.GetRecords());
+  EXPECT_EQ(1u, decoder.GetMalformed());
+  EXPECT_EQ("info num: 0\ninfo num: \ninfo num: 2\n", out.str());
+}
@@ -0,0 +1,75 @@
+#include "log_format.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace {
+std::string Format(const LogPattern &pattern, std::string_view format,
+                   const std::string &args) {
+  LogTimeFormatter time_formatter;
+  std::string text;
+  EXPECT_TRUE(pattern.Format(
+      time_formatter, {0, LogLevel::kError, "src/a.cpp", 42, format, args},
+      text));
+  return text;
+}
+
+template <typename... Args>
+std::string Encode(const Args &...args) {
+  std::string encoded;
+  (AppendLogArg(encoded, args), ...);
+  return encoded;
+}
+}  // namespace
+
+TEST(LogPattern, CompilesFields) {
+  LogPattern pattern("%l|%f:%n|%%|%m");
+  EXPECT_EQ("error|src/a.cpp:42|%|x = 5\n",
+            Format(pattern, "x = {}", Encode(5)));
+  EXPECT_EQ("\n", Format(LogPattern(""), "x", ""));
+  EXPECT_THROW(LogPattern("%q"), std::invalid_argument);
+  EXPECT_THROW(LogPattern("%"), std::invalid_argument);
+}
+
+TEST(LogPattern, FormatsNumbersShortest) {
+  LogPattern pattern("%m");
+  EXPECT_EQ("0.1 1e+300 -0 inf 0.30000000000000004\n",
+            Format(pattern, "{} {} {} {} {}",
+                   Encode(0.1, 1e300, -0.0,
+                          std::numeric_limits<double>::infinity(),
+                          0.1 + 0.2)));
+  EXPECT_EQ("-9223372036854775808 18446744073709551615 c\n",
+            Format(pattern, "{} {} {}",
+                   Encode(std::numeric_limits<int64_t>::min(),
+                          std::numeric_limits<uint64_t>::max(), 'c')));
+
+  // Fields without an argument are kept, arguments without a field are
+  // dropped.
+  EXPECT_EQ("1 {}\n", Format(pattern, "{} {}", Encode(1)));
+  EXPECT_EQ("1\n", Format(pattern, "{}", Encode(1, 2)));
+}
+
+TEST(LogPattern, StaysWithinMaxSize) {
+  LogPattern pattern;
+  std::string args = Encode(-1, 1u, -1.2345678901234567e-300,
+                            std::numeric_limits<int64_t>::min(), "");
+  LogTimeFormatter time_formatter;
+  LogRecordView record = {0, LogLevel::kWarning, "f.cpp", 1 << 30,
+                          "{}{}{}{}{}", args};
+  std::string buf(pattern.MaxSize(record), '\0');
+  bool ok = true;
+  char *end = pattern.Format(time_formatter, record, buf.data(), ok);
+  EXPECT_TRUE(ok);
+  EXPECT_LE(end - buf.data(), buf.size());
+
+  // A cut argument leaves the message up to it.
+  args = Encode(-1, 1u, 0.5);
+  args.pop_back();
+  std::string text;
+  record.args = args;
+  EXPECT_FALSE(LogPattern("%m").Format(time_formatter, record, text));
+  EXPECT_EQ("-11\n", text);
+}
@@ -0,0 +1,50 @@
+#include "log_level.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+// Sites as the LOG macro declares them.
+constinit LogSite debug_site(LogLevel::kDebug, "src/module.cpp", 10, "");
+constinit LogSite info_site(LogLevel::kInfo, "src/module.cpp", 20, "");
+constinit LogSite error_site(LogLevel::kError, "src/other.cpp", 30, "");
+}  // namespace
+
+TEST(LogLevel, ParsesNames) {
+  LogLevel level;
+  ASSERT_TRUE(ParseLogLevel("warning", level));
+  EXPECT_EQ(LogLevel::kWarning, level);
+  EXPECT_STREQ("debug", LogLevelName(LogLevel::kDebug));
+  EXPECT_FALSE(ParseLogLevel("verbose", level));
+}
+
+TEST(LogLevel, FiltersSites) {
+  LogLevel saved = LogSites::GetLevel();
+
+  LogSites::SetLevel(LogLevel::kInfo);
+  EXPECT_FALSE(debug_site.Enabled());
+  EXPECT_TRUE(info_site.Enabled());
+  EXPECT_TRUE(error_site.Enabled());
+
+  // Registered sites follow the level.
+  LogSites::SetLevel(LogLevel::kDebug);
+  EXPECT_TRUE(debug_site.Enabled());
+  LogSites::SetLevel(LogLevel::kError);
+  EXPECT_FALSE(debug_site.Enabled());
+  EXPECT_FALSE(info_site.Enabled());
+  EXPECT_TRUE(error_site.Enabled());
+
+  LogSites::SetLevel(LogLevel::kTrace);
+  LogSites::SetSiteEnabled("module.cpp:20", false);
+  EXPECT_TRUE(debug_site.Enabled());
+  EXPECT_FALSE(info_site.Enabled());
+  LogSites::SetSiteEnabled("module.cpp", false);
+  EXPECT_FALSE(debug_site.Enabled());
+  EXPECT_TRUE(error_site.Enabled());
+
+  LogSites::SetSiteEnabled("module.cpp", true);
+  LogSites::SetSiteEnabled("module.cpp:20", true);
+  EXPECT_TRUE(debug_site.Enabled());
+  EXPECT_TRUE(info_site.Enabled());
+
+  LogSites::SetLevel(saved);
+}
@@ -0,0 +1,138 @@
+#include "message_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "lock-free/mpsc_queue.h"
+
+namespace {
+struct Message : public PooledMessage {
+  int value = 0;
+  int resets = 0;
+
+  void Reset() { ++resets; }
+};
+}  // namespace
+
+TEST(MessagePool, ReusesRecycledMessages) {
+  MessagePool<Message> pool;
+  std::unique_ptr<Message> msg = pool.Acquire();
+  Message *raw = msg.get();
+  EXPECT_EQ(0, raw->resets);
+  pool.Recycle(std::move(msg));
+
+  msg = pool.Acquire();
+  EXPECT_EQ(raw, msg.get());
+  EXPECT_EQ(1, msg->resets);
+  EXPECT_EQ(1, pool.GetAllocated());
+
+  // Still out, so this one is new.
+  std::unique_ptr<Message> other = pool.Acquire();
+  EXPECT_NE(raw, other.get());
+  EXPECT_EQ(2, pool.GetAllocated());
+  pool.Recycle(std::move(other));
+}
+
+TEST(MessagePool, SteadyStateDoesNotAllocate) {
+  const int kProducers = 3;
+  const int kPerProducer = 20000;
+  const int kInFlight = 16;
+  MessagePool<Message> pool;
+  lock_free::MpscQueue<Message> queue;
+  std::atomic_int out[kProducers] = {};
+
+  std::thread consumer([&] {
+    std::unique_ptr<Message> msg;
+    for (int i = 0; i < kProducers * kPerProducer; ++i) {
+      ASSERT_TRUE(queue.Dequeue(msg));
+      int producer = msg->value;
+      pool.Recycle(std::move(msg));
+      out[producer].fetch_sub(1);
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        // Bound the messages out, as a bounded log queue does.
+        while (out[p].load() == kInFlight) {
+          std::this_thread::yield();
+        }
+        out[p].fetch_add(1);
+        std::unique_ptr<Message> msg = pool.Acquire();
+        msg->value = p;
+        queue.Enqueue(std::move(msg));
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  consumer.join();
+
+  // A producer allocates about as many messages as it has out at once; a
+  // return still being linked in may cost it one more now and then.
+  EXPECT_LE(pool.GetAllocated(), uint64_t(kProducers) * kInFlight * 2);
+}
+
+// Messages returned to the cache of a thread that has exited go to the
+// next thread, which adopts the cache.
+TEST(MessagePool, AdoptsCachesOfExitedThreads) {
+  MessagePool<Message> pool;
+  std::vector<std::unique_ptr<Message>> out;
+  std::thread([&] {
+    for (int i = 0; i < 4; ++i) {
+      out.push_back(pool.Acquire());
+    }
+  }).join();
+  for (auto &msg : out) {
+    pool.Recycle(std::move(msg));
+  }
+  EXPECT_EQ(4, pool.GetAllocated());
+  EXPECT_EQ(1u, pool.GetCaches());
+
+  for (int round = 0; round < 10; ++round) {
+    std::thread([&] {
+      std::vector<std::unique_ptr<Message>> msgs;
+      for (int i = 0; i < 4; ++i) {
+        msgs.push_back(pool.Acquire());
+      }
+      for (auto &msg : msgs) {
+        pool.Recycle(std::move(msg));
+      }
+    }).join();
+  }
+  EXPECT_EQ(4, pool.GetAllocated());
+  EXPECT_EQ(1u, pool.GetCaches());
+}
+
+// Threads outliving their pools drop their entries for them, and exit
+// cleanly after the pool is gone.
+TEST(MessagePool, ThreadsOutlivePools) {
+  for (int i = 0; i < 1000; ++i) {
+    MessagePool<Message> pool;
+    pool.Recycle(pool.Acquire());
+    EXPECT_EQ(1, pool.GetAllocated());
+  }
+
+  auto pool = std::make_unique<MessagePool<Message>>();
+  std::atomic_bool acquired = false, destroyed = false;
+  std::thread thread([&] {
+    pool->Recycle(pool->Acquire());
+    acquired = true;
+    while (!destroyed) {
+      std::this_thread::yield();
+    }
+  });
+  while (!acquired) {
+    std::this_thread::yield();
+  }
+  pool.reset();
+  destroyed = true;
+  thread.join();
+}
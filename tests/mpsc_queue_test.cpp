@@ -0,0 +1,80 @@
+#include "lock-free/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+struct Item : public lock_free::MpscNode {
+  Item(int p, int v) : producer(p), value(v) {}
+  int producer;
+  int value;
+};
+}  // namespace
+
+TEST(MpscQueue, Fifo) {
+  lock_free::MpscQueue<Item> queue;
+  std::unique_ptr<Item> item;
+  EXPECT_FALSE(queue.TryDequeue(item));
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::make_unique<Item>(0, i)));
+  }
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(item));
+    EXPECT_EQ(i, item->value);
+  }
+  EXPECT_FALSE(queue.TryDequeue(item));
+
+  // The stub is reused once the queue has run empty.
+  EXPECT_TRUE(queue.Enqueue(std::make_unique<Item>(0, 5)));
+  std::vector<std::unique_ptr<Item>> batch;
+  EXPECT_EQ(1, queue.TryDequeueAll(batch));
+  EXPECT_EQ(5, batch[0]->value);
+}
+
+TEST(MpscQueue, KeepsPerProducerOrder) {
+  const int kProducers = 4;
+  const int kPerProducer = 20000;
+  lock_free::MpscQueue<Item> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        queue.Enqueue(std::make_unique<Item>(p, i));
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  std::vector<std::unique_ptr<Item>> batch;
+  int received = 0;
+  while (received < kProducers * kPerProducer) {
+    received += queue.DequeueAll(batch);
+    for (auto &item : batch) {
+      EXPECT_EQ(next[item->producer]++, item->value);
+    }
+    batch.clear();
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+}
+
+TEST(MpscQueue, StopWakesConsumer) {
+  lock_free::MpscQueue<Item> queue;
+  std::thread consumer([&queue] {
+    std::unique_ptr<Item> item;
+    EXPECT_TRUE(queue.Dequeue(item));
+    EXPECT_EQ(1, item->value);
+    EXPECT_FALSE(queue.Dequeue(item));
+  });
+  queue.Enqueue(std::make_unique<Item>(0, 1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.Stop();
+  consumer.join();
+
+  EXPECT_FALSE(queue.Enqueue(std::make_unique<Item>(0, 2)));
+}
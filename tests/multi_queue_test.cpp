@@ -0,0 +1,71 @@
+#include "lock/multi_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(MultiQueue, ReturnsEveryElementOnce) {
+  locks::MultiQueue<int> queue(4);
+  EXPECT_EQ(8, queue.GetQueuesNumber());
+
+  int value;
+  EXPECT_FALSE(queue.TryDequeue(value));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(queue.Enqueue(std::move(i)));
+  }
+
+  std::set<int> values;
+  while (queue.TryDequeue(value)) {
+    EXPECT_TRUE(values.insert(value).second);
+  }
+  EXPECT_EQ(100, values.size());
+}
+
+TEST(MultiQueue, SingleSubQueueIsFifo) {
+  locks::MultiQueue<int> queue(1, 1);
+  for (int i = 0; i < 10; ++i) {
+    queue.Enqueue(std::move(i));
+  }
+  int value;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(queue.TryDequeue(value));
+    EXPECT_EQ(i, value);
+  }
+}
+
+TEST(MultiQueue, BlockedConsumersGetAllElements) {
+  const int kThreads = 4;
+  const int kPerThread = 10000;
+  locks::MultiQueue<int> queue(2 * kThreads);
+
+  std::atomic_long sum = 0;
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; ++t) {
+    consumers.emplace_back([&] {
+      int value;
+      while (queue.Dequeue(value)) {
+        sum += value;
+      }
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&] {
+      for (int i = 1; i <= kPerThread; ++i) {
+        queue.Enqueue(std::move(i));
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  queue.Stop();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+
+  EXPECT_EQ(static_cast<long>(kThreads) * kPerThread * (kPerThread + 1) / 2,
+            sum);
+}
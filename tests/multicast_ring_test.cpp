@@ -0,0 +1,128 @@
+#include "lock-free/multicast_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+using lock_free::MulticastRing;
+using lock_free::Producers;
+using lock_free::Sequence;
+
+struct Event {
+  int value = 0;
+  int doubled = 0;
+};
+}  // namespace
+
+TEST(MulticastRing, RejectsCapacity) {
+  EXPECT_THROW(MulticastRing<int>(0), std::invalid_argument);
+  EXPECT_THROW(MulticastRing<int>(6), std::invalid_argument);
+}
+
+TEST(MulticastRing, EveryConsumerSeesEveryEvent) {
+  const int kConsumers = 3;
+  const int kEvents = 10000;
+  MulticastRing<int, Producers::kSingle> ring(8);
+  Sequence sequences[kConsumers];
+  for (auto &sequence : sequences) {
+    ring.AddGatingSequence(&sequence);
+  }
+  auto barrier = ring.NewBarrier();
+
+  std::vector<std::vector<int>> seen(kConsumers);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&, c] {
+      ring.Process(barrier, sequences[c],
+                   [&seen, c](int &value, bool) { seen[c].push_back(value); });
+    });
+  }
+
+  for (int i = 0; i < kEvents; ++i) {
+    int64_t seq = ring.Claim();
+    ring.Get(seq) = i;
+    ring.Publish(seq);
+  }
+  ring.Stop();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+
+  for (int c = 0; c < kConsumers; ++c) {
+    ASSERT_EQ(kEvents, seen[c].size());
+    for (int i = 0; i < kEvents; ++i) {
+      ASSERT_EQ(i, seen[c][i]);
+    }
+  }
+}
+
+TEST(MulticastRing, DependentStageRunsAfter) {
+  const int kProducers = 3;
+  const int kPerProducer = 5000;
+  MulticastRing<Event> ring(16);
+  Sequence first;
+  Sequence second;
+  ring.AddGatingSequence(&second);
+  auto first_barrier = ring.NewBarrier();
+  auto second_barrier = ring.NewBarrier({&first});
+
+  std::thread first_stage([&] {
+    ring.Process(first_barrier, first,
+                 [](Event &event, bool) { event.doubled = event.value * 2; });
+  });
+  long sum = 0;
+  bool ordered = true;
+  std::thread second_stage([&] {
+    ring.Process(second_barrier, second, [&](Event &event, bool) {
+      ordered = ordered && event.doubled == event.value * 2;
+      sum += event.value;
+    });
+  });
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&ring] {
+      for (int i = 1; i <= kPerProducer; ++i) {
+        int64_t seq = ring.Claim();
+        ring.Get(seq).value = i;
+        ring.Publish(seq);
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  ring.Stop();
+  first_stage.join();
+  second_stage.join();
+
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(long(kProducers) * kPerProducer * (kPerProducer + 1) / 2, sum);
+}
+
+TEST(MulticastRing, SlowestConsumerGatesWrap) {
+  MulticastRing<int, Producers::kSingle> ring(4);
+  Sequence fast;
+  Sequence slow;
+  ring.AddGatingSequence(&fast);
+  ring.AddGatingSequence(&slow);
+
+  int64_t seq;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(ring.TryClaim(seq));
+    ring.Publish(seq);
+  }
+  EXPECT_FALSE(ring.TryClaim(seq));
+
+  fast.Set(3);
+  EXPECT_FALSE(ring.TryClaim(seq));
+  slow.Set(1);
+  ASSERT_TRUE(ring.TryClaim(seq));
+  EXPECT_EQ(4, seq);
+  ASSERT_TRUE(ring.TryClaim(seq));
+  EXPECT_EQ(5, seq);
+  EXPECT_FALSE(ring.TryClaim(seq));
+}
@@ -0,0 +1,62 @@
+#ifndef QUEUE_TEST_UTIL_H
+#define QUEUE_TEST_UTIL_H
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Each of `threads` threads passes 0..per_thread-1 through the queue,
+// dequeuing an element after each enqueue, and the sum of what comes out
+// is checked. The elements are ints or std::unique_ptr<int>; threads
+// register with queues that take registrations.
+template <typename Queue>
+void ExpectManyToManySum(Queue &queue, int threads = 4,
+                         int per_thread = 20000) {
+  typedef typename Queue::value_type T;
+  std::vector<std::thread> workers;
+  std::vector<long> sums(threads, 0);
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&queue, &sums, t, per_thread] {
+      if constexpr (requires { queue.RegisterThread(); }) {
+        queue.RegisterThread();
+      }
+      for (int i = 0; i < per_thread; ++i) {
+        T data;
+        if constexpr (std::is_same_v<T, int>) {
+          data = i;
+        } else {
+          data = std::make_unique<int>(i);
+        }
+        while (!queue.Enqueue(std::move(data))) {
+          std::this_thread::yield();
+        }
+        T value;
+        while (!queue.TryDequeue(value)) {
+          std::this_thread::yield();
+        }
+        if constexpr (std::is_same_v<T, int>) {
+          sums[t] += value;
+        } else {
+          sums[t] += *value;
+        }
+      }
+      if constexpr (requires { queue.UnregisterThread(); }) {
+        queue.UnregisterThread();
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  long total = 0;
+  for (long sum : sums) {
+    total += sum;
+  }
+  EXPECT_EQ(long(threads) * per_thread * (per_thread - 1) / 2, total);
+}
+
+#endif  // QUEUE_TEST_UTIL_H
@@ -56,8 +56,9 @@ TEST(Config, RingBufferFull2) {
   EXPECT_FALSE(buf.Empty());
   EXPECT_TRUE(buf.Full());
 
+  // 5 elements live in 8 slots, the sixth one goes past the fifth slot.
   EXPECT_EQ(1, buf.GetHeadIdx());
-  EXPECT_EQ(0, buf.GetTailIdx());
+  EXPECT_EQ(5, buf.GetTailIdx());
 }
 
 TEST(Config, RingBufferEnqueueToFull) {
@@ -104,6 +105,94 @@ TEST(Config, RingBufferDequeueElements) {
   EXPECT_FALSE(buf.Full());
 }
 
+namespace {
+// Not default constructible, counts live instances.
+struct Counted {
+  explicit Counted(int v) : val(v) { ++live; }
+  Counted(Counted&& other) : val(other.val) { ++live; }
+  Counted& operator=(Counted&& other) = default;
+  ~Counted() { --live; }
+
+  int val;
+  static int live;
+};
+int Counted::live = 0;
+}  // namespace
+
+TEST(Config, StaticRingBufferWraps) {
+  locks::RingBuffer<A, 4> buf;
+  static_assert(sizeof(buf) < sizeof(A) * 4 + 4 * sizeof(size_t));
+
+  A a;
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(buf.Enqueue(A({i})));
+    EXPECT_TRUE(buf.Enqueue(A({i + 100})));
+    EXPECT_TRUE(buf.Dequeue(a));
+    EXPECT_EQ(i, a.val);
+    EXPECT_TRUE(buf.Dequeue(a));
+    EXPECT_EQ(i + 100, a.val);
+  }
+  for (int i : {1, 2, 3, 4}) {
+    EXPECT_TRUE(buf.Enqueue(A({i})));
+  }
+  EXPECT_TRUE(buf.Full());
+  EXPECT_FALSE(buf.Enqueue(A({5})));
+  EXPECT_EQ(0, buf.GetHeadIdx());
+  EXPECT_EQ(3, buf.GetTailIdx());
+}
+
+TEST(Config, RingBufferConstructsInPlace) {
+  {
+    locks::RingBuffer<Counted, 4> buf;
+    EXPECT_EQ(0, Counted::live);
+    for (int i : {1, 2, 3}) {
+      EXPECT_TRUE(buf.Enqueue(Counted(i)));
+    }
+    EXPECT_EQ(3, Counted::live);
+
+    Counted c(0);
+    EXPECT_TRUE(buf.Dequeue(c));
+    EXPECT_EQ(1, c.val);
+    EXPECT_EQ(3, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+
+  {
+    locks::RingBuffer<Counted> buf(3);
+    for (int i : {1, 2, 3}) {
+      EXPECT_TRUE(buf.Enqueue(Counted(i)));
+    }
+    EXPECT_TRUE(buf.Full());
+    EXPECT_EQ(3, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+TEST(Config, RingBufferClaimInPlace) {
+  locks::RingBuffer<Counted, 2> buf;
+  Counted* slot = buf.ClaimWrite(7);
+  ASSERT_NE(nullptr, slot);
+  EXPECT_EQ(7, slot->val);
+  // Claimed but not committed yet.
+  EXPECT_TRUE(buf.Empty());
+  buf.Commit();
+  EXPECT_TRUE(buf.Emplace(8));
+  EXPECT_EQ(nullptr, buf.ClaimWrite(9));
+  EXPECT_EQ(2, Counted::live);
+
+  slot = buf.ClaimRead();
+  ASSERT_NE(nullptr, slot);
+  EXPECT_EQ(7, slot->val);
+  buf.Release();
+  EXPECT_EQ(1, Counted::live);
+  slot = buf.ClaimRead();
+  ASSERT_NE(nullptr, slot);
+  EXPECT_EQ(8, slot->val);
+  buf.Release();
+  EXPECT_EQ(nullptr, buf.ClaimRead());
+  EXPECT_EQ(0, Counted::live);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
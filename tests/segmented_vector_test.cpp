@@ -0,0 +1,74 @@
+#include "lock-free/segmented_vector.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+using lock_free::SegmentedVector;
+}  // namespace
+
+TEST(SegmentedVector, ElementsStayInPlace) {
+  SegmentedVector<std::unique_ptr<int>, 4> vector;
+  EXPECT_EQ(nullptr, vector.At(0));
+
+  // Spans segments of 4, 8, 16 and 32 elements.
+  std::vector<const std::unique_ptr<int> *> addresses;
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(i, vector.PushBack(std::make_unique<int>(i)));
+    addresses.push_back(vector.At(i));
+  }
+  EXPECT_EQ(50, vector.Size());
+  EXPECT_EQ(nullptr, vector.At(50));
+
+  int expected = 0;
+  vector.ForEach([&](size_t index, const std::unique_ptr<int> &value) {
+    EXPECT_EQ(expected, index);
+    EXPECT_EQ(expected, *value);
+    EXPECT_EQ(addresses[index], &value);
+    ++expected;
+  });
+  EXPECT_EQ(50, expected);
+}
+
+TEST(SegmentedVector, ConcurrentWriters) {
+  const int kThreads = 4;
+  const int kPerThread = 50000;
+  SegmentedVector<long, 16> vector;
+
+  std::atomic_bool done = false;
+  // Reads while the vector grows.
+  std::thread reader([&] {
+    while (!done) {
+      long sum = 0;
+      vector.ForEach([&sum](size_t, long value) { sum += value; });
+      ASSERT_GE(sum, 0);
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; ++t) {
+    writers.emplace_back([&vector] {
+      for (int i = 1; i <= kPerThread; ++i) {
+        vector.EmplaceBack(i);
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  reader.join();
+
+  ASSERT_EQ(size_t(kThreads) * kPerThread, vector.Size());
+  long sum = 0;
+  size_t count = 0;
+  vector.ForEach([&](size_t, long value) {
+    sum += value;
+    ++count;
+  });
+  EXPECT_EQ(vector.Size(), count);
+  EXPECT_EQ(long(kThreads) * kPerThread * (kPerThread + 1) / 2, sum);
+}
@@ -0,0 +1,60 @@
+#include "sharded_counter.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(ShardedCounter, SumsAllThreads) {
+  // More threads than shards, so some of them share a cell.
+  const int kThreads = kCounterShards + 8;
+  const int kPerThread = 1000;
+  ShardedCounter counter;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&counter] {
+      for (int i = 0; i < kPerThread; ++i) {
+        counter.Add();
+      }
+      counter.Add(2);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(uint64_t(kThreads) * (kPerThread + 2), counter.Read());
+
+  counter.Reset();
+  EXPECT_EQ(0, counter.Read());
+}
+
+TEST(ShardedStats, MergesCells) {
+  ShardedStats stats;
+  ShardedStats::Summary empty = stats.Read();
+  EXPECT_EQ(0, empty.count);
+  EXPECT_EQ(0, empty.min);
+  EXPECT_EQ(0, empty.max);
+  EXPECT_EQ(0, empty.Mean());
+
+  const int kThreads = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&stats, t] {
+      for (int i = 1; i <= 100; ++i) {
+        stats.Add(t * 100 + i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  stats.Add(-5);
+
+  ShardedStats::Summary summary = stats.Read();
+  EXPECT_EQ(401, summary.count);
+  EXPECT_DOUBLE_EQ(400 * 401 / 2 - 5, summary.sum);
+  EXPECT_DOUBLE_EQ(-5, summary.min);
+  EXPECT_DOUBLE_EQ(400, summary.max);
+  EXPECT_DOUBLE_EQ(summary.sum / 401, summary.Mean());
+}
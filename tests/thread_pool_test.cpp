@@ -0,0 +1,126 @@
+// Built against src/thread_pool.cpp once per flavour of queue_types.h, see
+// CMakeLists.txt.
+
+#include "thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "logger.h"
+
+namespace {
+constexpr size_t kMinThreads = 1;
+constexpr size_t kMaxThreads = 4;
+constexpr auto kIdleTimeout = std::chrono::milliseconds(50);
+constexpr auto kDeadline = std::chrono::seconds(10);
+
+class ElasticPool : public ::testing::Test {
+ protected:
+  LoggerQueue logger_queue_{0, AdmissionPolicy::kBlock};
+#ifdef LOCK_FREE
+  TasksQueue tasks_{0, AdmissionPolicy::kBlock, kMaxThreads + 1};
+#else
+  TasksQueue tasks_{0, AdmissionPolicy::kBlock};
+#endif
+  ThreadPool pool_{tasks_, logger_queue_, kMinThreads, kMaxThreads,
+                   kIdleTimeout};
+  std::atomic_size_t done_ = 0;
+
+  void SetUp() override { RegisterQueueThread(tasks_); }
+
+  void TearDown() override {
+    pool_.Stop();
+    pool_.Join();
+    UnregisterQueueThread(tasks_);
+  }
+
+  void AddTasks(size_t count, std::chrono::milliseconds duration) {
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_TRUE(tasks_.Enqueue(std::function<void()>([this, duration] {
+        std::this_thread::sleep_for(duration);
+        ++done_;
+      })));
+    }
+  }
+
+  // Waits until pred() holds, returns false after kDeadline.
+  template <typename Pred>
+  bool WaitFor(Pred pred) {
+    auto deadline = std::chrono::steady_clock::now() + kDeadline;
+    while (!pred()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  // A backlog large enough to grow the pool to kMaxThreads, then idle until
+  // every extra worker is retired.
+  void GrowAndShrink() {
+    size_t done = done_;
+    size_t retired = pool_.GetRetiredThreadsNumber();
+    AddTasks(60, std::chrono::milliseconds(10));
+    EXPECT_TRUE(WaitFor([&] { return done_ == done + 60; }));
+    EXPECT_TRUE(WaitFor([&] {
+      return pool_.GetRetiredThreadsNumber() ==
+             retired + kMaxThreads - kMinThreads;
+    }));
+  }
+};
+}  // namespace
+
+TEST_F(ElasticPool, GrowsUnderBacklog) {
+  AddTasks(60, std::chrono::milliseconds(10));
+  EXPECT_TRUE(WaitFor([&] { return done_ == 60; }));
+  EXPECT_EQ(kMaxThreads, pool_.GetPeakThreadsNumber());
+  EXPECT_EQ(kMaxThreads, pool_.GetSpawnedThreadsNumber());
+}
+
+TEST_F(ElasticPool, RetiresIdleWorkers) {
+  GrowAndShrink();
+  EXPECT_EQ(kMaxThreads, pool_.GetPeakThreadsNumber());
+  EXPECT_EQ(kMaxThreads - kMinThreads, pool_.GetRetiredThreadsNumber());
+
+  // The last kMinThreads workers stay.
+  std::this_thread::sleep_for(kIdleTimeout * 3);
+  EXPECT_EQ(kMaxThreads - kMinThreads, pool_.GetRetiredThreadsNumber());
+}
+
+// Tasks trickling in one at a time never make a backlog, so the pool does
+// not grow.
+TEST_F(ElasticPool, NoGrowthWithoutBacklog) {
+  for (size_t i = 0; i < 20; ++i) {
+    AddTasks(1, std::chrono::milliseconds(1));
+    EXPECT_TRUE(WaitFor([&] { return done_ == i + 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(kMinThreads, pool_.GetPeakThreadsNumber());
+  EXPECT_EQ(0u, pool_.GetRetiredThreadsNumber());
+}
+
+// Retired workers unregister from the tasks queue, so workers spawned later
+// take over their hazard pointer records instead of claiming new ones.
+TEST_F(ElasticPool, ReusesRecordsOfRetiredWorkers) {
+  for (int cycle = 0; cycle < 3; ++cycle) {
+    GrowAndShrink();
+#ifdef LOCK_FREE
+    // A retired worker unregisters right after it is counted.
+    EXPECT_TRUE(WaitFor([&] {
+      return tasks_.GetRegisteredThreads() == kMinThreads + 1;
+    }));
+#endif
+  }
+  EXPECT_EQ(kMinThreads + 3 * (kMaxThreads - kMinThreads),
+            pool_.GetSpawnedThreadsNumber());
+
+#ifdef LOCK_FREE
+  // The workers and this thread.
+  EXPECT_LE(tasks_.GetHazardRecords(), kMaxThreads + 1);
+#endif
+}
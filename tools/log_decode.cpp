@@ -0,0 +1,80 @@
+// Converts a binary log (see binary_log.h) back to the text layout of the
+// logger. The file is mapped and decoded by a LogDecoder on all threads.
+//
+// Usage: log-decode <binary log> [<text log> [<pattern>]]
+//
+// The pattern is the log_pattern of the run, see LogPattern.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "log_decoder.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: log-decode <binary log> [<text log> [<pattern>]]"
+              << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<LogPattern> pattern;
+  try {
+    pattern.reset(new LogPattern(argc == 4 ? argv[3] : kDefaultLogPattern));
+  } catch (std::exception &e) {
+    std::cerr << "Can't parse log pattern: " << e.what() << std::endl;
+    return 1;
+  }
+
+  int fd = open(argv[1], O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    std::cerr << "Can't open binary log: " << argv[1] << std::endl;
+    return 1;
+  }
+  size_t size = st.st_size;
+  const char *data = nullptr;
+  if (size > 0) {
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      std::cerr << "Can't map binary log: " << argv[1] << std::endl;
+      return 1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(map);
+  }
+  close(fd);
+
+  std::ofstream file;
+  if (argc >= 3) {
+    file.open(argv[2], std::ios::trunc);
+    if (!file) {
+      std::cerr << "Can't open text log: " << argv[2] << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = argc >= 3 ? file : std::cout;
+
+  LogDecoder decoder(*pattern, out,
+                  std::max(1u, std::thread::hardware_concurrency()));
+  bool ok = decoder.Decode(data, size);
+  out.flush();
+  if (!ok) {
+    std::cerr << "Malformed binary log after " << decoder.GetRecords()
+              << " records" << std::endl;
+    return 1;
+  }
+  if (decoder.GetMalformed() > 0) {
+    std::cerr << decoder.GetMalformed() << " records with malformed arguments"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}